@@ -0,0 +1,168 @@
+// Host benchmark runner: the on-device kernel timings plus host-only ones,
+// one "BENCH name=... iterations=... total_us=... ns_per_op=..." line per
+// result on stdout and in the results file, so runs can be diffed or
+// loaded by scripts. Built once per output count (nametag_bench_<n>).
+//
+//   nametag_bench_<n> [results file]
+
+#include <host.h>
+#include "diagnostics.h"
+#include "events.h"
+#include "button_manager.h"
+
+// Prints to stdout and, when open, the results file
+class BenchOutput : public Print {
+public:
+    explicit BenchOutput(FILE* file) : file(file) {}
+
+    size_t write(uint8_t c) override {
+        if (file) fputc(c, file);
+        return fputc(c, stdout) == EOF ? 0 : 1;
+    }
+
+private:
+    FILE* file;
+};
+
+static StateManager stateManager;
+static StateBuffer stateBuffer;
+static OutputManager outputManager;
+static Recorder recorder;
+static Diagnostics diagnostics;
+
+// Host-only kernels run longer than the device ones: the host clock is in
+// microseconds and a 6-pixel frame takes a fraction of one
+static const uint32_t HOST_ITERATIONS = 20000;
+static volatile uint32_t benchSink;
+
+static void report(Print& out, const char* name, uint32_t iterations, unsigned long elapsedUs) {
+    out.printf("BENCH name=%s iterations=%u total_us=%lu ns_per_op=%lu\n", name, (unsigned)iterations,
+               elapsedUs, (unsigned long)((uint64_t)elapsedUs * 1000 / iterations));
+}
+
+// compose() over the user layer plus a full animation layer in each blend
+// mode, then with a crossfade running on top. Scratch compositor: too big
+// for the device's stack at 64 outputs, which is why this is host-only.
+static void benchCompositor(Print& out) {
+    static Compositor compositor;
+    for (int layer = 0; layer < Compositor::TRANSITION_LAYER; layer++) {
+        Rgb16Color* pixels = compositor.getLayer((Compositor::LayerId)layer);
+        for (int i = 0; i < Compositor::NUM_PIXELS; i++) {
+            pixels[i] = LEDUtils::hsvToRgb16(i * 40 + layer * 85, 255, 0x8000 + i * 100);
+        }
+    }
+    compositor.setOpacity(Compositor::USER_LAYER, 255);
+
+    static const struct {
+        BlendMode mode;
+        const char* name;
+    } MODES[] = {{BlendMode::REPLACE, "Compositor::compose/replace"},
+                 {BlendMode::ADD, "Compositor::compose/add"},
+                 {BlendMode::ALPHA, "Compositor::compose/alpha"},
+                 {BlendMode::MAX, "Compositor::compose/max"}};
+    for (const auto& mode : MODES) {
+        compositor.setBlendMode(Compositor::ANIMATION_LAYER, mode.mode);
+        compositor.setOpacity(Compositor::ANIMATION_LAYER, 192);
+        unsigned long start = micros();
+        for (uint32_t i = 0; i < HOST_ITERATIONS; i++) {
+            compositor.compose(0);
+            benchSink += compositor.getPixel(0).R;
+        }
+        report(out, mode.name, HOST_ITERATIONS, micros() - start);
+    }
+
+    // Every layer up, the transition layer mid-fade
+    compositor.setOpacity(Compositor::OVERLAY_LAYER, 128);
+    compositor.crossfade(60000, 0);
+    unsigned long start = micros();
+    for (uint32_t i = 0; i < HOST_ITERATIONS; i++) {
+        compositor.compose(30000);
+        benchSink += compositor.getPixel(0).R;
+    }
+    report(out, "Compositor::compose/crossfade", HOST_ITERATIONS, micros() - start);
+}
+
+// The power estimate is kept up in setPixel() and turned into a scale at
+// show(); the limited run against the unlimited one is the limiter's cost
+static void benchPowerLimit(Print& out) {
+    static LEDController leds;
+    unsigned long start = micros();
+    for (uint32_t i = 0; i < HOST_ITERATIONS; i++) {
+        for (int pixel = 0; pixel < LEDController::NUM_LEDS; pixel++) {
+            leds.setPixel(pixel, LEDUtils::hsvToRgb16(pixel * 40, 255, (uint16_t)(i * 7)));
+        }
+    }
+    report(out, "LEDController::setPixel/frame", HOST_ITERATIONS, micros() - start);
+    benchSink += leds.getEstimatedCurrent();
+
+    static const struct {
+        uint16_t budget;
+        const char* name;
+    } BUDGETS[] = {{0, "LEDController::show/unlimited"}, {100, "LEDController::show/limited"}};
+    for (int pixel = 0; pixel < LEDController::NUM_LEDS; pixel++) leds.setPixel(pixel, {0xFFFF, 0xFFFF, 0xFFFF});
+    for (const auto& budget : BUDGETS) {
+        leds.setPowerBudget(budget.budget);
+        start = micros();
+        for (uint32_t i = 0; i < HOST_ITERATIONS; i++) leds.show();
+        report(out, budget.name, HOST_ITERATIONS, micros() - start);
+        benchSink += leds.getPowerLimitPercent();
+    }
+}
+
+// Both ends of the 74HC595/74HC165 chains: a whole status frame shifted out,
+// and button scans with nothing pressed and with every eighth button held
+// (each held button is timed every scan)
+static void benchShiftAndScan(Print& out) {
+    static ShiftRegisterController shiftRegister;
+    unsigned long start = micros();
+    for (uint32_t i = 0; i < HOST_ITERATIONS; i++) {
+        for (int led = 1; led <= NAMETAG_NUM_OUTPUTS; led++) shiftRegister.updateRegister(led, (i + led) & 1);
+        shiftRegister.updateAll();
+    }
+    report(out, "ShiftRegisterController/frame", HOST_ITERATIONS, micros() - start);
+
+    static ButtonManager buttons;
+    host::attachShiftInChain(ButtonManager::LOAD_PIN, ButtonManager::CLOCK_PIN, ButtonManager::DATA_PIN,
+                             ButtonManager::NUM_BUTTONS);
+    buttons.begin();
+    start = micros();
+    for (uint32_t i = 0; i < HOST_ITERATIONS; i++) buttons.update();
+    report(out, "ButtonManager::update/idle", HOST_ITERATIONS, micros() - start);
+
+    for (int i = 0; i < ButtonManager::NUM_BUTTONS; i += 8) host::setButton(i, true);
+    start = micros();
+    for (uint32_t i = 0; i < HOST_ITERATIONS; i++) buttons.update();
+    report(out, "ButtonManager::update/held", HOST_ITERATIONS, micros() - start);
+    for (int i = 0; i < ButtonManager::NUM_BUTTONS; i += 8) host::setButton(i, false);
+}
+
+int main(int argc, char** argv) {
+    FILE* file = nullptr;
+    if (argc > 1) {
+        file = fopen(argv[1], "w");
+        if (!file) {
+            perror(argv[1]);
+            return 1;
+        }
+    }
+    BenchOutput out(file);
+    out.printf("BENCH_CONFIG outputs=%d\n", NAMETAG_NUM_OUTPUTS);
+
+    stateManager.publish(stateBuffer);
+    outputManager.begin(stateBuffer);
+    recorder.begin(stateManager);
+    diagnostics.begin(stateManager, outputManager, recorder);
+
+    // Same subscriber work as the sketch's double click
+    EventBus::subscribe([](const ButtonEventData& event) {
+        if (event.type == ButtonEvent::DOUBLE_CLICKED) stateManager.toggleAnimationMode();
+    });
+
+    diagnostics.runBenchmarks(out);
+    benchCompositor(out);
+    benchPowerLimit(out);
+    benchShiftAndScan(out);
+
+    if (file) fclose(file);
+    return 0;
+}
\ No newline at end of file
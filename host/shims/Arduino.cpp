@@ -0,0 +1,390 @@
+#include "host.h"
+#include <Shifty.h>
+#include <WiFiUdp.h>
+#include <ArduinoOTA.h>
+#include <chrono>
+#include <deque>
+#include <thread>
+
+extern "C" {
+#include <user_interface.h>
+}
+
+HardwareSerial Serial;
+EspClass ESP;
+ESP8266WiFiClass WiFi;
+ArduinoOTAClass ArduinoOTA;
+
+namespace host {
+
+uint8_t stationCount = 0;
+
+static bool simulated = false;
+static unsigned long simulatedMicros = 0;
+static const auto startTime = std::chrono::steady_clock::now();
+
+static const int NUM_PINS = 32;
+static int pinLevels[NUM_PINS];
+static bool pinsInitialized = false;
+static void (*interruptHandlers[NUM_PINS])() = {};
+static int analogValue = 512;
+static std::vector<int> analogSignal;
+static uint32_t analogRateHz = 0;
+static unsigned long analogStartMicros = 0;
+
+struct ShiftInChain {
+    bool attached = false;
+    uint8_t loadPin = 0, clockPin = 0, dataPin = 0;
+    std::vector<bool> buttons;
+    std::vector<bool> latched;
+    size_t position = 0;
+};
+static ShiftInChain chain;
+
+static std::vector<RgbColor> pixels;
+static uint32_t shows = 0;
+static std::vector<bool> shiftBits;
+static std::deque<char> serialQueue;
+
+static std::vector<Packet> inbox;
+static std::vector<Packet> outbox;
+static uint32_t dropped = 0;
+
+static uint32_t armedSleepUs = 0;
+static unsigned long sleptMicros = 0;     // In forced light sleep, unseen by micros()
+static uint32_t lightSleeps = 0;
+static void (*fpmWakeupCallback)() = nullptr;
+static int sleepWakePin = -1;
+static unsigned long sleepWakeAfterUs = 0;
+static unsigned long sleepWakeMillis = 0;
+static const uint32_t RTC_PERIOD_Q12 = 23552;
+
+static void initPins() {
+    if (pinsInitialized) return;
+    for (int i = 0; i < NUM_PINS; i++) pinLevels[i] = HIGH;
+    pinsInitialized = true;
+}
+
+void useSimulatedTime(bool on) {
+    if (on && !simulated) simulatedMicros = 1000000;   // Same start every run
+    simulated = on;
+}
+
+void advanceMicros(unsigned long us) {
+    simulatedMicros += us;
+}
+
+void setPin(uint8_t pin, int level) {
+    initPins();
+    if (pin < NUM_PINS) pinLevels[pin] = level;
+}
+
+int getPin(uint8_t pin) {
+    initPins();
+    return pin < NUM_PINS ? pinLevels[pin] : LOW;
+}
+
+void setAnalog(int value) {
+    analogValue = value;
+}
+
+void setAnalogSignal(const std::vector<int>& samples, uint32_t rateHz) {
+    analogSignal = samples;
+    analogRateHz = rateHz;
+    analogStartMicros = micros();
+}
+
+void fireInterrupt(uint8_t pin) {
+    if (pin < NUM_PINS && interruptHandlers[pin]) interruptHandlers[pin]();
+}
+
+void attachShiftInChain(uint8_t loadPin, uint8_t clockPin, uint8_t dataPin, int buttons) {
+    chain.attached = true;
+    chain.loadPin = loadPin;
+    chain.clockPin = clockPin;
+    chain.dataPin = dataPin;
+    chain.buttons.assign(buttons, false);
+    chain.latched.assign(buttons, false);
+    chain.position = 0;
+}
+
+void setButton(int index, bool pressed) {
+    if (index >= 0 && index < (int)chain.buttons.size()) chain.buttons[index] = pressed;
+}
+
+void recordShow(const std::vector<RgbColor>& shown) {
+    pixels = shown;
+    shows++;
+}
+
+const std::vector<RgbColor>& shownPixels() {
+    return pixels;
+}
+
+uint32_t showCount() {
+    return shows;
+}
+
+void recordShiftOut(const std::vector<bool>& bits) {
+    shiftBits = bits;
+}
+
+const std::vector<bool>& shiftedOutBits() {
+    return shiftBits;
+}
+
+std::string frameLine() {
+    std::string line;
+    char hex[8];
+    for (const RgbColor& pixel : pixels) {
+        snprintf(hex, sizeof(hex), "%02X%02X%02X", pixel.R, pixel.G, pixel.B);
+        line += hex;
+    }
+    line += ' ';
+    for (size_t i = 0; i < shiftBits.size(); i += 8) {
+        uint8_t byte = 0;
+        for (size_t b = 0; b < 8 && i + b < shiftBits.size(); b++) byte |= shiftBits[i + b] << b;
+        snprintf(hex, sizeof(hex), "%02X", byte);
+        line += hex;
+    }
+    return line;
+}
+
+void serialInput(const char* text) {
+    while (*text) serialQueue.push_back(*text++);
+}
+
+std::vector<Packet>& udpInbox() {
+    return inbox;
+}
+
+std::vector<Packet>& udpOutbox() {
+    return outbox;
+}
+
+bool deliver(Packet packet) {
+    if (inbox.size() >= UDP_RX_QUEUE) {
+        dropped++;
+        return false;
+    }
+    packet.timeUs = micros();
+    inbox.push_back(packet);
+    return true;
+}
+
+uint32_t udpDropped() {
+    return dropped;
+}
+
+unsigned long wallMillis() {
+    return (micros() + sleptMicros) / 1000;
+}
+
+uint32_t lightSleepCount() {
+    return lightSleeps;
+}
+
+void pressDuringSleep(uint8_t pin, unsigned long afterUs) {
+    sleepWakePin = pin;
+    sleepWakeAfterUs = afterUs;
+}
+
+unsigned long pinWakeMillis() {
+    return sleepWakeMillis;
+}
+
+}  // namespace host
+
+unsigned long micros() {
+    if (host::simulated) return host::simulatedMicros;
+    auto elapsed = std::chrono::steady_clock::now() - host::startTime;
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+}
+
+unsigned long millis() {
+    return micros() / 1000;
+}
+
+void delay(unsigned long ms) {
+    if (host::armedSleepUs > 0) {
+        // Forced light sleep: the CPU clock stops, so millis() misses it
+        unsigned long slept = host::armedSleepUs;
+        host::armedSleepUs = 0;
+        host::lightSleeps++;
+        if (host::sleepWakePin >= 0 && host::sleepWakeAfterUs < slept) {
+            slept = host::sleepWakeAfterUs;
+            host::sleptMicros += slept;
+            host::setPin(host::sleepWakePin, LOW);
+            host::sleepWakeMillis = host::wallMillis();
+            host::sleepWakePin = -1;
+        } else {
+            host::sleptMicros += slept;
+        }
+        if (host::fpmWakeupCallback) host::fpmWakeupCallback();
+
+        // The delay's timer ran on through the sleep; the rest passes awake
+        if (host::simulated && ms * 1000UL > slept) host::simulatedMicros += ms * 1000UL - slept;
+        return;
+    }
+    if (host::simulated) {
+        host::simulatedMicros += ms * 1000UL;
+    } else {
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    }
+}
+
+void delayMicroseconds(unsigned int us) {
+    if (host::simulated) host::simulatedMicros += us;
+}
+
+void yield() {}
+
+long random(long max) {
+    return max > 0 ? rand() % max : 0;
+}
+
+long random(long min, long max) {
+    return min < max ? min + random(max - min) : min;
+}
+
+void randomSeed(unsigned long seed) {
+    srand(seed);
+}
+
+int analogRead(uint8_t) {
+    if (host::analogRateHz > 0) {
+        uint64_t index = (uint64_t)(micros() - host::analogStartMicros) * host::analogRateHz / 1000000;
+        if (index < host::analogSignal.size()) return host::analogSignal[index];
+    }
+    return host::analogValue;
+}
+
+void pinMode(uint8_t, uint8_t) {}
+
+int digitalRead(uint8_t pin) {
+    host::ShiftInChain& chain = host::chain;
+    if (chain.attached && pin == chain.dataPin) {
+        if (chain.position >= chain.latched.size()) return HIGH;
+        return chain.latched[chain.position] ? LOW : HIGH;
+    }
+    return host::getPin(pin);
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    host::ShiftInChain& chain = host::chain;
+    if (chain.attached) {
+        if (pin == chain.loadPin && value == LOW) {
+            chain.latched = chain.buttons;
+            chain.position = 0;
+        } else if (pin == chain.clockPin && value == HIGH && host::getPin(pin) == LOW) {
+            chain.position++;
+        }
+    }
+    host::setPin(pin, value);
+}
+
+void attachInterrupt(uint8_t interrupt, void (*handler)(), int) {
+    if (interrupt < host::NUM_PINS) host::interruptHandlers[interrupt] = handler;
+}
+
+void detachInterrupt(uint8_t interrupt) {
+    if (interrupt < host::NUM_PINS) host::interruptHandlers[interrupt] = nullptr;
+}
+
+size_t Print::printf(const char* format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (length < 0) return 0;
+    if (length >= (int)sizeof(buffer)) length = sizeof(buffer) - 1;
+    return write((const uint8_t*)buffer, length);
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    return fwrite(buffer, 1, size, stdout);
+}
+
+int HardwareSerial::available() {
+    return host::serialQueue.size();
+}
+
+int HardwareSerial::read() {
+    if (host::serialQueue.empty()) return -1;
+    char c = host::serialQueue.front();
+    host::serialQueue.pop_front();
+    return (uint8_t)c;
+}
+
+extern "C" void panic() {
+    fprintf(stderr, "panic()\n");
+    abort();
+}
+
+int WiFiUDP::parsePacket() {
+    std::vector<host::Packet>& inbox = host::udpInbox();
+    if (inbox.empty()) return 0;
+    current = inbox.front();
+    inbox.erase(inbox.begin());
+    readOffset = 0;
+    return current.data.size();
+}
+
+int WiFiUDP::read(uint8_t* buffer, size_t length) {
+    size_t count = std::min(length, current.data.size() - readOffset);
+    memcpy(buffer, current.data.data() + readOffset, count);
+    readOffset += count;
+    return count;
+}
+
+int WiFiUDP::beginPacket(IPAddress address, uint16_t port) {
+    outgoing.address = address;
+    outgoing.port = port;
+    outgoing.data.clear();
+    return 1;
+}
+
+size_t WiFiUDP::write(const uint8_t* buffer, size_t length) {
+    outgoing.data.insert(outgoing.data.end(), buffer, buffer + length);
+    return length;
+}
+
+int WiFiUDP::endPacket() {
+    outgoing.timeUs = micros();
+    host::udpOutbox().push_back(outgoing);
+    return 1;
+}
+
+extern "C" {
+
+bool wifi_set_opmode_current(uint8_t) {
+    return true;
+}
+
+void wifi_fpm_set_sleep_type(sleep_type) {}
+void wifi_fpm_open() {}
+void wifi_fpm_close() {}
+
+void wifi_fpm_set_wakeup_cb(fpm_wakeup_cb cb) {
+    host::fpmWakeupCallback = cb;
+}
+
+int8_t wifi_fpm_do_sleep(uint32_t sleepUs) {
+    host::armedSleepUs = sleepUs;
+    return 0;
+}
+
+uint32_t system_get_rtc_time() {
+    return (uint32_t)(((uint64_t)micros() + host::sleptMicros) * 4096 / host::RTC_PERIOD_Q12);
+}
+
+uint32_t system_rtc_clock_cali_proc() {
+    return host::RTC_PERIOD_Q12;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,112 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Just enough of the ESP8266 Arduino core to build the sketch's modules on a
+// desktop. Time, pins and the serial port are simulated; see host.h for the
+// hooks tests use to drive them.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <math.h>
+#include <algorithm>
+
+using std::min;
+using std::max;
+
+#define PROGMEM
+#define IRAM_ATTR
+#define ICACHE_RAM_ATTR
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t*)(addr))
+
+#define PI 3.1415926535897932384626433832795
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x00
+#define INPUT_PULLUP 0x02
+#define OUTPUT 0x01
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+#define A0 17
+
+typedef uint8_t byte;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+int analogRead(uint8_t pin);
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t value);
+void attachInterrupt(uint8_t interrupt, void (*handler)(), int mode);
+void detachInterrupt(uint8_t interrupt);
+inline uint8_t digitalPinToInterrupt(uint8_t pin) { return pin; }
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+        size_t n = 0;
+        while (size--) n += write(*buffer++);
+        return n;
+    }
+
+    size_t print(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+    size_t print(int value) { return printf("%d", value); }
+    size_t print(unsigned long value) { return printf("%lu", value); }
+    size_t println() { return print("\n"); }
+    size_t println(const char* s) { return print(s) + println(); }
+    size_t println(int value) { return print(value) + println(); }
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+};
+
+// Writes to stdout, reads whatever host::serialInput() queued
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long) {}
+    size_t setRxBufferSize(size_t size) { return size; }
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    int available() override;
+    int read() override;
+};
+
+extern HardwareSerial Serial;
+
+class EspClass {
+public:
+    uint32_t getChipId() { return 0x00C0FFEE; }
+    uint32_t getFreeHeap() { return 40000; }
+    uint32_t getMaxFreeBlockSize() { return 38000; }
+    uint8_t getHeapFragmentation() { return 5; }
+    uint32_t getFreeContStack() { return 3000; }
+    uint32_t random() { return (uint32_t)::random(0x7FFFFFFF); }
+};
+
+extern EspClass ESP;
+
+extern "C" void panic();
+
+#endif
\ No newline at end of file
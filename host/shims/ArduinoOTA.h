@@ -0,0 +1,22 @@
+#ifndef HOST_ARDUINOOTA_H
+#define HOST_ARDUINOOTA_H
+
+#include <Arduino.h>
+
+typedef int ota_error_t;
+enum { OTA_AUTH_ERROR, OTA_BEGIN_ERROR, OTA_CONNECT_ERROR, OTA_RECEIVE_ERROR, OTA_END_ERROR };
+
+class ArduinoOTAClass {
+public:
+    void setPassword(const char*) {}
+    template <typename F> void onStart(F) {}
+    template <typename F> void onEnd(F) {}
+    template <typename F> void onProgress(F) {}
+    template <typename F> void onError(F) {}
+    void begin() {}
+    void handle() {}
+};
+
+extern ArduinoOTAClass ArduinoOTA;
+
+#endif
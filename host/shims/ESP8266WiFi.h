@@ -0,0 +1,52 @@
+#ifndef HOST_ESP8266WIFI_H
+#define HOST_ESP8266WIFI_H
+
+#include <Arduino.h>
+
+class IPAddress {
+public:
+    IPAddress() : address(0) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+        : address(a | (b << 8) | (c << 16) | ((uint32_t)d << 24)) {}
+    IPAddress(uint32_t address) : address(address) {}
+    operator uint32_t() const { return address; }
+    uint8_t operator[](int index) const { return address >> (8 * index); }
+
+private:
+    uint32_t address;
+};
+
+enum WiFiMode_t { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 };
+enum WiFiSleepType_t { WIFI_NONE_SLEEP = 0, WIFI_LIGHT_SLEEP = 1, WIFI_MODEM_SLEEP = 2 };
+
+namespace host {
+extern uint8_t stationCount;    // Clients on the soft AP
+}
+
+class ESP8266WiFiClass {
+public:
+    bool mode(WiFiMode_t m) {
+        current = m;
+        return true;
+    }
+    WiFiMode_t getMode() const { return current; }
+    bool softAP(const char*, const char*) { return true; }
+    IPAddress softAPIP() { return IPAddress(192, 168, 4, 1); }
+    uint8_t softAPgetStationNum() { return current == WIFI_OFF ? 0 : host::stationCount; }
+    bool setSleepMode(WiFiSleepType_t type, uint8_t = 0) {
+        sleepType = type;
+        return true;
+    }
+    WiFiSleepType_t getSleepMode() const { return sleepType; }
+    bool forceSleepBegin(uint32_t = 0) { return true; }
+    bool forceSleepWake() { return true; }
+    int8_t setOutputPower(float) { return 0; }
+
+private:
+    WiFiMode_t current = WIFI_OFF;
+    WiFiSleepType_t sleepType = WIFI_MODEM_SLEEP;
+};
+
+extern ESP8266WiFiClass WiFi;
+
+#endif
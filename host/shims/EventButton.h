@@ -0,0 +1,34 @@
+#ifndef HOST_EVENTBUTTON_H
+#define HOST_EVENTBUTTON_H
+
+#include <Arduino.h>
+
+// Interface only: direct-pin button gestures come from the library on the
+// device, host tests drive the shift-in scanner instead
+class EventButton {
+public:
+    using EventButtonCallback = void (*)(EventButton&);
+
+    explicit EventButton(uint8_t pin) : pin(pin) {}
+
+    void setUserId(int id) { user = id; }
+    int userId() const { return user; }
+    void setClickHandler(EventButtonCallback f) { onClick = f; }
+    void setDoubleClickHandler(EventButtonCallback f) { onDoubleClick = f; }
+    void setLongPressHandler(EventButtonCallback f) { onLongPress = f; }
+    void setReleasedHandler(EventButtonCallback f) { onReleased = f; }
+    void setLongClickDuration(unsigned int ms) { longClickMs = ms; }
+    unsigned long previousDuration() const { return 0; }
+    void update() {}
+
+private:
+    uint8_t pin;
+    int user = 0;
+    unsigned int longClickMs = 0;
+    EventButtonCallback onClick = nullptr;
+    EventButtonCallback onDoubleClick = nullptr;
+    EventButtonCallback onLongPress = nullptr;
+    EventButtonCallback onReleased = nullptr;
+};
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef HOST_NEOPIXELBUS_H
+#define HOST_NEOPIXELBUS_H
+
+#include <Arduino.h>
+#include <vector>
+
+struct RgbColor {
+    uint8_t R;
+    uint8_t G;
+    uint8_t B;
+
+    RgbColor(uint8_t r, uint8_t g, uint8_t b) : R(r), G(g), B(b) {}
+    RgbColor(uint8_t brightness = 0) : R(brightness), G(brightness), B(brightness) {}
+};
+
+struct NeoGammaEquationMethod {
+    static uint8_t Correct(uint8_t value) {
+        return (uint8_t)(pow(value / 255.0f, 1.0f / 0.45f) * 255.0f + 0.5f);
+    }
+};
+
+// Same curve as the library's table, computed once
+struct NeoGammaTableMethod {
+    static uint8_t Correct(uint8_t value) {
+        static uint8_t table[256];
+        static bool filled = false;
+        if (!filled) {
+            for (int i = 0; i < 256; i++) table[i] = NeoGammaEquationMethod::Correct(i);
+            filled = true;
+        }
+        return table[value];
+    }
+};
+
+template <typename T_METHOD>
+class NeoGamma {
+public:
+    static RgbColor Correct(const RgbColor& original) {
+        return RgbColor(T_METHOD::Correct(original.R), T_METHOD::Correct(original.G),
+                        T_METHOD::Correct(original.B));
+    }
+};
+
+struct NeoGrbFeature {};
+struct NeoEsp8266Uart1Ws2812xMethod {};
+
+namespace host {
+void recordShow(const std::vector<RgbColor>& pixels);
+}
+
+// Keeps the pixels in memory; Show() hands them to host::shownPixels()
+template <typename T_COLOR_FEATURE, typename T_METHOD>
+class NeoPixelBus {
+public:
+    NeoPixelBus(uint16_t count, uint8_t) : pixels(count) {}
+
+    void Begin() {}
+    void Show() { host::recordShow(pixels); }
+    bool CanShow() const { return true; }
+
+    void SetPixelColor(uint16_t index, RgbColor color) {
+        if (index < pixels.size()) pixels[index] = color;
+    }
+
+    RgbColor GetPixelColor(uint16_t index) const {
+        return index < pixels.size() ? pixels[index] : RgbColor(0);
+    }
+
+private:
+    std::vector<RgbColor> pixels;
+};
+
+#endif
\ No newline at end of file
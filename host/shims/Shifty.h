@@ -0,0 +1,35 @@
+#ifndef HOST_SHIFTY_H
+#define HOST_SHIFTY_H
+
+#include <Arduino.h>
+#include <vector>
+
+namespace host {
+void recordShiftOut(const std::vector<bool>& bits);
+}
+
+// Latches the written bits into host::shiftedOutBits() at the end of a batch
+class Shifty {
+public:
+    void setBitCount(int count) { bits.assign(count, false); }
+    void setPins(int, int, int) {}
+    void batchWriteBegin() { batching = true; }
+    void batchWriteEnd() {
+        batching = false;
+        host::recordShiftOut(bits);
+    }
+
+    void writeBit(int index, bool value) {
+        if (index < 0 || index >= (int)bits.size()) return;
+        bits[index] = value;
+        if (!batching) host::recordShiftOut(bits);
+    }
+
+    bool readBit(int index) const { return index >= 0 && index < (int)bits.size() && bits[index]; }
+
+private:
+    std::vector<bool> bits;
+    bool batching = false;
+};
+
+#endif
\ No newline at end of file
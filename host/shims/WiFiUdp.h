@@ -0,0 +1,50 @@
+#ifndef HOST_WIFIUDP_H
+#define HOST_WIFIUDP_H
+
+#include <ESP8266WiFi.h>
+#include <vector>
+
+namespace host {
+
+struct Packet {
+    IPAddress address;
+    uint16_t port;
+    std::vector<uint8_t> data;
+    unsigned long timeUs = 0;   // micros() when delivered or sent
+};
+
+// Datagrams for the next parsePacket() calls, and everything sent
+std::vector<Packet>& udpInbox();
+std::vector<Packet>& udpOutbox();
+
+// A datagram arriving from the radio. The stack holds this many unread
+// ones in its pbuf pool and drops the rest, counted by udpDropped().
+static const size_t UDP_RX_QUEUE = 16;
+bool deliver(Packet packet);
+uint32_t udpDropped();
+
+}  // namespace host
+
+class WiFiUDP {
+public:
+    uint8_t begin(uint16_t) { return 1; }
+    void stop() {}
+
+    int parsePacket();
+    int read(uint8_t* buffer, size_t length);
+    int available() const { return current.data.size() - readOffset; }
+    void flush() { readOffset = current.data.size(); }
+    IPAddress remoteIP() const { return current.address; }
+    uint16_t remotePort() const { return current.port; }
+
+    int beginPacket(IPAddress address, uint16_t port);
+    size_t write(const uint8_t* buffer, size_t length);
+    int endPacket();
+
+private:
+    host::Packet current;
+    size_t readOffset = 0;
+    host::Packet outgoing;
+};
+
+#endif
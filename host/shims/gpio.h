@@ -0,0 +1,17 @@
+#ifndef HOST_GPIO_H
+#define HOST_GPIO_H
+
+#include <stdint.h>
+
+#define GPIO_ID_PIN(n) (n)
+
+enum GPIO_INT_TYPE {
+    GPIO_PIN_INTR_DISABLE = 0,
+    GPIO_PIN_INTR_LOLEVEL = 4,
+    GPIO_PIN_INTR_HILEVEL = 5
+};
+
+inline void gpio_pin_wakeup_enable(uint32_t, GPIO_INT_TYPE) {}
+inline void gpio_pin_wakeup_disable() {}
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef HOST_HOST_H
+#define HOST_HOST_H
+
+#include <Arduino.h>
+#include <NeoPixelBus.h>
+#include <string>
+#include <vector>
+
+// Hooks for tests to drive the simulated hardware
+namespace host {
+
+// Time runs off the steady clock until simulated time is switched on. That
+// starts at 1 s and only moves when a test advances it or the code under
+// test delays.
+void useSimulatedTime(bool simulated);
+void advanceMicros(unsigned long us);
+inline void advanceMillis(unsigned long ms) { advanceMicros(ms * 1000UL); }
+unsigned long wallMillis();     // millis() plus time spent in forced light sleep
+uint32_t lightSleepCount();     // Forced light sleeps taken so far
+
+// Pins read HIGH (pulled up) unless set
+void setPin(uint8_t pin, int level);
+int getPin(uint8_t pin);
+void setAnalog(int value);
+// Plays samples (0-1023) on A0 at rateHz from now, then back to the
+// setAnalog() level
+void setAnalogSignal(const std::vector<int>& samples, uint32_t rateHz);
+void fireInterrupt(uint8_t pin);   // Runs the handler attached to the pin
+// The next forced light sleep is ended afterUs in by the pin going LOW (a
+// button press), if the timer doesn't end it first
+void pressDuringSleep(uint8_t pin, unsigned long afterUs);
+unsigned long pinWakeMillis();     // wallMillis() of that press
+
+// A 74HC165 chain: LOW on loadPin latches the buttons, each rising clock
+// edge shifts the next one out. Pressed buttons read LOW.
+void attachShiftInChain(uint8_t loadPin, uint8_t clockPin, uint8_t dataPin, int buttons);
+void setButton(int index, bool pressed);
+
+// What the strip and status LED chain showed last
+const std::vector<RgbColor>& shownPixels();
+uint32_t showCount();
+const std::vector<bool>& shiftedOutBits();
+
+// Both of the above as one line of hex: RGB per pixel, a space, then the
+// status LED chain a byte at a time (the host/golden file format)
+std::string frameLine();
+
+// Queued for Serial.read()
+void serialInput(const char* text);
+
+}  // namespace host
+
+#endif
\ No newline at end of file
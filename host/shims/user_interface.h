@@ -0,0 +1,27 @@
+#ifndef HOST_USER_INTERFACE_H
+#define HOST_USER_INTERFACE_H
+
+#include <stdint.h>
+
+// Forced light sleep: wifi_fpm_do_sleep() arms it and the next delay()
+// sleeps, during which simulated millis() stands still as on the chip. The
+// delay's own timer counts the sleep, so whatever is left of it after an
+// early (pin) wake passes awake.
+enum sleep_type { NONE_SLEEP_T = 0, LIGHT_SLEEP_T, MODEM_SLEEP_T };
+
+#define NULL_MODE 0x00
+
+bool wifi_set_opmode_current(uint8_t mode);
+void wifi_fpm_set_sleep_type(sleep_type type);
+void wifi_fpm_open();
+void wifi_fpm_close();
+int8_t wifi_fpm_do_sleep(uint32_t sleepUs);
+typedef void (*fpm_wakeup_cb)(void);
+void wifi_fpm_set_wakeup_cb(fpm_wakeup_cb cb);   // Runs on every wakeup, timer or pin
+
+// RTC timer, which keeps counting through light sleep. The period comes
+// back in us with 12 fractional bits (5.75 us here).
+uint32_t system_get_rtc_time();
+uint32_t system_rtc_clock_cali_proc();
+
+#endif
@@ -0,0 +1,136 @@
+// Synthesizes a 120 BPM kick over a steady 1 kHz tone, then silence, writes
+// it out as a WAV, reads it back and plays it into A0 for the sketch's audio
+// tasks, scheduled beside the render tasks as they run while listening:
+//  - every kick is a beat, and silence is not
+//  - the beat flash pattern flashes on the kicks and fades to black after
+//  - the tone lands in its band (1 kHz is bin 12.8, band 5)
+//  - capture never blocks: each run takes one sample, and only the slots
+//    the render and analysis runs sit on are held
+
+#include <host.h>
+#include <math.h>
+#include "check.h"
+#include "audio_input.h"
+#include "audio_analyzer.h"
+#include "scheduler.h"
+#include "state_manager.h"
+#include "../tools/wav.h"
+
+static const uint32_t RATE_HZ = 16000;
+static const int MUSIC_S = 10;
+static const int SILENCE_S = 4;    // Long enough for the beat flash to die out
+static const int KICK_MS = 500;     // 120 BPM
+
+// Typical run times of the other tasks
+static const unsigned long STATE_US = 1200;
+static const unsigned long OUTPUT_US = 600;
+static const unsigned long ANALYZE_US = 600;
+
+static StateManager stateManager;
+static AudioInput audioInput;
+static AudioAnalyzer audioAnalyzer;
+static Scheduler scheduler;
+static int analyzeTask;
+static unsigned long start;
+static uint32_t musicBeats = 0, silenceBeats = 0, blocks = 0, captureRuns = 0;
+static uint32_t bandSum[AudioFeatures::NUM_BANDS] = {};
+static uint16_t flashPeak = 0;
+
+// Same tasks as setupTasks() while listening, output at the STANDARD refresh
+static void setupTasks() {
+    scheduler.addPeriodic("state", []() {
+        stateManager.update();
+        host::advanceMicros(STATE_US);
+        uint16_t brightness = stateManager.getAnimationState(0).brightness;
+        if (brightness > flashPeak) flashPeak = brightness;
+    }, PRIORITY_RENDER, StateManager::UPDATE_INTERVAL_MS, 2000);
+    scheduler.addPeriodic("output", []() { host::advanceMicros(OUTPUT_US); }, PRIORITY_RENDER, 20, 1000);
+    int audioTask = scheduler.addPeriodic("audio", []() {
+        captureRuns++;
+        if (audioInput.poll()) scheduler.trigger(analyzeTask);
+    }, PRIORITY_INPUT, 1, 150);
+    scheduler.setPeriodUs(audioTask, AudioInput::SAMPLE_PERIOD_US);
+    analyzeTask = scheduler.addEvent("analyze", []() {
+        int16_t block[AudioInput::BLOCK_SIZE];
+        CHECK(audioInput.readBlock(block));
+        audioAnalyzer.process(block);
+        stateManager.setAudioFeatures(audioAnalyzer.getFeatures());
+        host::advanceMicros(ANALYZE_US);
+
+        const AudioFeatures& features = audioAnalyzer.getFeatures();
+        unsigned long ms = millis() - start;
+        if (ms < MUSIC_S * 1000UL) {
+            if (features.beat) musicBeats++;
+            for (int b = 0; b < AudioFeatures::NUM_BANDS; b++) bandSum[b] += features.bands[b];
+            blocks++;
+        } else if (ms >= MUSIC_S * 1000UL + KICK_MS && features.beat) {
+            silenceBeats++;
+        }
+    }, PRIORITY_INPUT, 1500);
+}
+
+static std::vector<int16_t> synthesize() {
+    std::vector<int16_t> samples;
+    for (uint32_t i = 0; i < (MUSIC_S + SILENCE_S) * RATE_HZ; i++) {
+        double t = (double)i / RATE_HZ;
+        double value = 0;
+        if (t < MUSIC_S) {
+            double sinceKick = fmod(t, KICK_MS / 1000.0);
+            value += 0.7 * exp(-sinceKick / 0.04) * sin(2 * M_PI * 100 * sinceKick);
+            value += 0.1 * sin(2 * M_PI * 1000 * t);
+        }
+        samples.push_back((int16_t)(value * 32767));
+    }
+    return samples;
+}
+
+int main(int argc, char** argv) {
+    const char* path = argc > 1 ? argv[1] : "audio_wav.wav";
+    std::vector<int16_t> written = synthesize();
+    CHECK(wav::write(path, written, RATE_HZ));
+    std::vector<int16_t> samples;
+    uint32_t rateHz = 0;
+    CHECK(wav::read(path, samples, rateHz));
+    CHECK_EQ(rateHz, RATE_HZ);
+    CHECK(samples == written);
+
+    host::useSimulatedTime(true);
+    host::setAnalogSignal(wav::toAdc(samples), rateHz);
+    start = millis();
+    stateManager.toggleAnimationMode();
+    stateManager.toggleSoundReactive();
+    CHECK(stateManager.setAnimationPattern(7));   // Beat flash
+    setupTasks();
+    audioInput.start();
+
+    // loop(): a pass, then wait out whatever idle time is reported
+    while (millis() - start < (MUSIC_S + SILENCE_S) * 1000UL) {
+        unsigned long before = micros();
+        scheduler.runOnce();
+        if (micros() != before) continue;
+        unsigned long idleUs = scheduler.getIdleTimeUs();
+        host::advanceMicros(idleUs > 0 ? idleUs : 1);
+    }
+
+    const uint32_t slots = (MUSIC_S + SILENCE_S) * AudioInput::SAMPLE_RATE_HZ;
+    printf("%u beats in %d s of music, %u in silence, bands", musicBeats, MUSIC_S, silenceBeats);
+    for (int b = 0; b < AudioFeatures::NUM_BANDS; b++) printf(" %u", bandSum[b] / blocks);
+    printf(", %u samples held of %u, flash peak %u\n", (unsigned)audioInput.getHeldSamples(), slots,
+           flashPeak);
+
+    const uint32_t KICKS = MUSIC_S * 1000 / KICK_MS;
+    CHECK(musicBeats >= KICKS - 1 && musicBeats <= KICKS);
+    CHECK_EQ(silenceBeats, 0);
+    CHECK(flashPeak > StateManager::MAX_BRIGHTNESS / 2);
+    for (int i = 0; i < StateManager::MAX_OUTPUTS; i++) {
+        CHECK_EQ(stateManager.getAnimationState(i).brightness, 0);
+    }
+    for (int b = 3; b < AudioFeatures::NUM_BANDS; b++) {
+        if (b != 5) CHECK(bandSum[5] > 2 * bandSum[b]);     // Kick spills into the bass bands only
+    }
+    CHECK(audioInput.getHeldSamples() < slots / 5);
+    CHECK(captureRuns + audioInput.getHeldSamples() >= slots * 99 / 100);    // Every slot filled
+    CHECK(blocks >= MUSIC_S * AudioInput::SAMPLE_RATE_HZ / AudioInput::BLOCK_SIZE * 99 / 100);
+
+    return checkResult("audio_wav");
+}
\ No newline at end of file
@@ -0,0 +1,111 @@
+// Drives a 74HC165 button chain through the gestures the shift-in scanner
+// recognizes and checks the events it publishes, in order, on buttons at
+// both ends of the chain. Then clicks pick patterns: buttons past the
+// regular patterns, and remote commands alike, can't reach the sound
+// patterns outside sound reactive mode.
+
+#include <host.h>
+#include <vector>
+#include "check.h"
+#include "button_manager.h"
+#include "remote_control.h"
+
+static ButtonManager buttons;
+static std::vector<ButtonEventData> events;
+
+// The button task polls every 2 ms
+static void hold(int index, bool pressed, unsigned long ms) {
+    host::setButton(index, pressed);
+    for (unsigned long t = 0; t < ms; t += 2) {
+        buttons.update();
+        host::advanceMillis(2);
+    }
+}
+
+static bool expect(std::initializer_list<ButtonEvent> expected, int index) {
+    bool match = events.size() == expected.size();
+    size_t i = 0;
+    for (ButtonEvent type : expected) {
+        if (!match) break;
+        match = events[i].type == type && events[i].buttonIndex == index;
+        i++;
+    }
+    events.clear();
+    return match;
+}
+
+int main() {
+    host::useSimulatedTime(true);
+    host::attachShiftInChain(ButtonManager::LOAD_PIN, ButtonManager::CLOCK_PIN, ButtonManager::DATA_PIN,
+                             ButtonManager::NUM_BUTTONS);
+    buttons.begin();
+    EventBus::subscribe([](const ButtonEventData& event) { events.push_back(event); });
+
+    const int INDICES[] = {0, ButtonManager::NUM_BUTTONS - 1};
+    for (int index : INDICES) {
+        hold(index, true, 80);
+        hold(index, false, 400);
+        CHECK(expect({ButtonEvent::CLICKED}, index));
+
+        hold(index, true, 80);
+        hold(index, false, 80);
+        hold(index, true, 80);
+        hold(index, false, 400);
+        CHECK(expect({ButtonEvent::DOUBLE_CLICKED}, index));
+
+        hold(index, true, 700);
+        hold(index, false, 400);
+        CHECK(expect({ButtonEvent::LONG_PRESSED, ButtonEvent::LONG_PRESS_RELEASED}, index));
+
+        // Click, then press again and hold: the click still counts
+        hold(index, true, 80);
+        hold(index, false, 80);
+        hold(index, true, 700);
+        hold(index, false, 400);
+        CHECK(expect({ButtonEvent::CLICKED, ButtonEvent::LONG_PRESSED, ButtonEvent::LONG_PRESS_RELEASED}, index));
+
+        // Contact bounce shorter than the debounce time is ignored
+        hold(index, true, 4);
+        hold(index, false, 400);
+        CHECK(expect({}, index));
+    }
+
+    // Party mode: clicks pick patterns
+    StateManager stateManager;
+    stateManager.toggleAnimationMode();
+    auto click = [&stateManager](int index) {
+        hold(index, true, 80);
+        hold(index, false, 400);
+        for (const ButtonEventData& event : events) stateManager.handleButtonEvent(event);
+        events.clear();
+    };
+    click(2);
+    CHECK_EQ(stateManager.getAnimationPattern(), 2);
+    for (int index = StateManager::NUM_BASE_PATTERNS; index < StateManager::NUM_PATTERNS; index++) {
+        click(index);
+        CHECK_EQ(stateManager.getAnimationPattern(), 2);
+    }
+
+    StateBuffer stateBuffer;
+    OutputManager outputManager;
+    PowerManager powerManager;
+    Recorder recorder;
+    Schedule schedule;
+    RemoteControl remoteControl;
+    stateManager.publish(stateBuffer);
+    outputManager.begin(stateBuffer);
+    remoteControl.begin(stateManager, outputManager, powerManager, recorder, schedule);
+    const uint8_t spectrum = StateManager::NUM_BASE_PATTERNS;
+    CHECK_EQ(remoteControl.applyCommand(RemoteControl::CMD_SET_PATTERN, &spectrum, 1),
+             RemoteControl::STATUS_BAD_REQUEST);
+    CHECK_EQ(stateManager.getAnimationPattern(), 2);
+
+    // Sound reactive: the same buttons pick the sound patterns
+    stateManager.toggleSoundReactive();
+    click(1);
+    CHECK_EQ(stateManager.getAnimationPattern(), StateManager::NUM_BASE_PATTERNS + 1);
+    CHECK_EQ(remoteControl.applyCommand(RemoteControl::CMD_SET_PATTERN, &spectrum, 1), RemoteControl::STATUS_OK);
+    CHECK_EQ(stateManager.getAnimationPattern(), StateManager::NUM_BASE_PATTERNS);
+
+    return checkResult("button_gestures");
+}
\ No newline at end of file
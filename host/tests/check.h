@@ -0,0 +1,36 @@
+#ifndef HOST_CHECK_H
+#define HOST_CHECK_H
+
+#include <stdio.h>
+
+// Minimal assertions: report every failure, exit non-zero at the end
+static int checkFailures = 0;
+
+#define CHECK(condition)                                                                 \
+    do {                                                                                 \
+        if (!(condition)) {                                                              \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            checkFailures++;                                                             \
+        }                                                                                \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                                        \
+    do {                                                                                  \
+        long long a_ = (long long)(actual), e_ = (long long)(expected);                   \
+        if (a_ != e_) {                                                                   \
+            fprintf(stderr, "%s:%d: %s == %lld, expected %lld\n", __FILE__, __LINE__,     \
+                    #actual, a_, e_);                                                     \
+            checkFailures++;                                                              \
+        }                                                                                 \
+    } while (0)
+
+static inline int checkResult(const char* name) {
+    if (checkFailures > 0) {
+        fprintf(stderr, "%s: %d check(s) failed\n", name, checkFailures);
+        return 1;
+    }
+    printf("%s: ok\n", name);
+    return 0;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,81 @@
+// Runs the render tasks on dim outputs until the badge goes idle:
+//  - refresh mode changes reach the output task's period
+//  - the frame left up while idle is the rounded one, not whichever
+//    dithered refresh happened to run last
+
+#include <host.h>
+#include "check.h"
+#include "output_manager.h"
+#include "power_manager.h"
+#include "scheduler.h"
+
+static const uint8_t WAKE_PIN = 5;
+
+static StateManager stateManager;
+static StateBuffer stateBuffer;
+static OutputManager outputManager;
+static PowerManager powerManager;
+static Scheduler scheduler;
+static int outputTask;
+
+// Same tasks and periods as setupTasks()
+static void setupTasks() {
+    int stateTask = scheduler.addPeriodic("state", []() {
+        stateManager.update();
+        stateManager.publish(stateBuffer);
+    }, PRIORITY_RENDER, StateManager::UPDATE_INTERVAL_MS, 2000);
+    outputTask = scheduler.addPeriodic("output", []() { outputManager.update(); },
+                                       PRIORITY_RENDER, outputManager.getRefreshInterval(), 1000);
+    outputManager.bindTask(scheduler, outputTask);
+
+    static const int WAKE_PINS[] = {WAKE_PIN};
+    powerManager.begin(scheduler, WAKE_PINS, 1, nullptr);
+    powerManager.suspendWhenIdle(stateTask);
+    powerManager.suspendWhenIdle(outputTask, []() { outputManager.flush(); });
+}
+
+static void run(unsigned long ms) {
+    unsigned long start = millis();
+    while (millis() - start < ms) {
+        scheduler.runOnce();
+        powerManager.update(outputManager.getLastFrameChange());
+        powerManager.idle(scheduler.getIdleTimeUs());
+    }
+}
+
+int main() {
+    host::useSimulatedTime(true);
+    stateManager.publish(stateBuffer);
+    outputManager.begin(stateBuffer);
+    setupTasks();
+
+    outputManager.setRefreshMode(RefreshMode::STANDARD);
+    CHECK_EQ(scheduler.getTask(outputTask).periodUs, OutputManager::STANDARD_REFRESH_MS * 1000);
+    outputManager.setRefreshMode(RefreshMode::FAST);
+    CHECK_EQ(scheduler.getTask(outputTask).periodUs, OutputManager::FAST_REFRESH_MS * 1000);
+
+    // Dim colors sit between 8-bit steps, so dithered refreshes alternate
+    for (uint8_t i = 0; i < StateManager::MAX_OUTPUTS; i++) {
+        stateManager.setOutput(i, true, i * 40, 0x3030 + i * 7);
+    }
+    run(PowerManager::IDLE_AFTER_MS + 500);
+    CHECK(powerManager.getState() == PowerState::IDLE);
+
+    const Frame& frame = outputManager.readFrame();
+    uint32_t unrounded = 0, between = 0;
+    for (int i = 0; i < LEDController::NUM_LEDS; i++) {
+        Rgb16Color exact = LEDUtils::applyGamma16(frame.pixels[i]);
+        RgbColor shown = host::shownPixels()[i];
+        uint16_t channels[3][2] = {{exact.R, shown.R}, {exact.G, shown.G}, {exact.B, shown.B}};
+        for (auto& channel : channels) {
+            if (channel[1] != (channel[0] + 0x80) >> 8) unrounded++;
+            if ((channel[0] & 0xFF) != 0) between++;
+        }
+    }
+    printf("idle frame: %u of %u channels between 8-bit steps, %u unrounded\n", between,
+           LEDController::NUM_LEDS * 3, unrounded);
+    CHECK_EQ(unrounded, 0);
+    CHECK(between > LEDController::NUM_LEDS);
+
+    return checkResult("dither_idle");
+}
\ No newline at end of file
@@ -0,0 +1,131 @@
+// Renders fixed scenarios through StateManager, OutputManager, the
+// compositor and the LED controller, and compares every strip refresh
+// (gamma-corrected, power limited, dithered 8-bit pixels plus the status
+// LED chain) with host/golden/<scenario>.txt.
+//
+//   golden_frames <golden dir>            compare
+//   golden_frames <golden dir> --update   rewrite after an intended change
+
+#include <host.h>
+#include <string>
+#include <fstream>
+#include "check.h"
+#include "state_manager.h"
+#include "output_manager.h"
+#include "diagnostics.h"
+
+struct Scenario {
+    const char* name;
+    uint16_t ticks;
+    void (*setup)(StateManager& sm, OutputManager& om);
+    void (*tick)(StateManager& sm, uint16_t tick);
+};
+
+// Dim outputs live mostly in the dither's low bits
+static void setupUser(StateManager& sm, OutputManager&) {
+    for (int i = 0; i < StateManager::MAX_OUTPUTS; i++) {
+        sm.setOutput(i, true, i * 40, 200 + i * 700);
+    }
+    sm.setColorCycling(1, true);
+    sm.setColorCycling(4, true);
+}
+
+static void setupPattern(StateManager& sm, OutputManager&, uint8_t pattern) {
+    Diagnostics::startPattern(sm, pattern);
+}
+
+#define PATTERN_SETUP(n) [](StateManager& sm, OutputManager& om) { setupPattern(sm, om, n); }
+
+static void setupLimited(StateManager& sm, OutputManager& om) {
+    setupUser(sm, om);
+    for (int i = 0; i < StateManager::MAX_OUTPUTS; i++) {
+        sm.setOutput(i, true, i * 40, StateManager::MAX_BRIGHTNESS);
+    }
+    om.getLEDController().setPowerBudget(60);
+    sm.setMasterBrightness(100);
+}
+
+static void tickCrossfade(StateManager& sm, uint16_t tick) {
+    Diagnostics::feedAudio(sm, tick);
+    if (tick == 40) sm.setAnimationPattern(3);
+}
+
+static void tickNotify(StateManager& sm, uint16_t tick) {
+    if (tick == 10) sm.notify(StateManager::NOTIFY_ON_HUE);
+    if (tick == 20) sm.notify(StateManager::NOTIFY_OFF_HUE);   // Restarts mid-fade
+}
+
+static const Scenario SCENARIOS[] = {
+    {"user", 100, setupUser, nullptr},
+    {"pattern0", 75, PATTERN_SETUP(0), Diagnostics::feedAudio},
+    {"pattern1", 75, PATTERN_SETUP(1), Diagnostics::feedAudio},
+    {"pattern2", 75, PATTERN_SETUP(2), Diagnostics::feedAudio},
+    {"pattern3", 75, PATTERN_SETUP(3), Diagnostics::feedAudio},
+    {"pattern4", 75, PATTERN_SETUP(4), Diagnostics::feedAudio},
+    {"pattern5", 75, PATTERN_SETUP(5), Diagnostics::feedAudio},
+    {"pattern6", 75, PATTERN_SETUP(6), Diagnostics::feedAudio},
+    {"pattern7", 75, PATTERN_SETUP(7), Diagnostics::feedAudio},
+    {"pattern8", 75, PATTERN_SETUP(8), Diagnostics::feedAudio},
+    {"crossfade", 80, PATTERN_SETUP(1), tickCrossfade},
+    {"limited", 50, setupLimited, nullptr},
+    {"notify", 50, setupUser, tickNotify},
+};
+
+static std::vector<std::string> render(const Scenario& scenario) {
+    StateManager sm;
+    StateBuffer buffer;
+    OutputManager om;
+    sm.publish(buffer);
+    om.begin(buffer);
+    scenario.setup(sm, om);
+
+    std::vector<std::string> frames;
+    unsigned long refreshes = StateManager::UPDATE_INTERVAL_MS / om.getRefreshInterval();
+    for (uint16_t tick = 0; tick < scenario.ticks; tick++) {
+        if (scenario.tick) scenario.tick(sm, tick);
+        sm.update();
+        sm.publish(buffer);
+        for (unsigned long r = 0; r < refreshes; r++) {
+            om.update();
+            frames.push_back(host::frameLine());
+            host::advanceMillis(om.getRefreshInterval());
+        }
+    }
+    return frames;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <golden dir> [--update]\n", argv[0]);
+        return 2;
+    }
+    std::string dir = argv[1];
+    bool update = argc > 2 && std::string(argv[2]) == "--update";
+    host::useSimulatedTime(true);
+
+    for (const Scenario& scenario : SCENARIOS) {
+        std::vector<std::string> frames = render(scenario);
+        std::string path = dir + "/" + scenario.name + ".txt";
+
+        if (update) {
+            std::ofstream out(path);
+            for (const std::string& frame : frames) out << frame << "\n";
+            printf("wrote %s (%zu frames)\n", path.c_str(), frames.size());
+            continue;
+        }
+
+        std::ifstream in(path);
+        CHECK(in.good());
+        std::string line;
+        size_t index = 0;
+        while (index < frames.size() && std::getline(in, line) && line == frames[index]) {
+            index++;
+        }
+        if (index < frames.size()) {
+            fprintf(stderr, "%s frame %zu:\n  expected %s\n  actual   %s\n", scenario.name, index,
+                    line.c_str(), frames[index].c_str());
+            checkFailures++;
+        }
+    }
+    return update ? 0 : checkResult("golden_frames");
+}
\ No newline at end of file
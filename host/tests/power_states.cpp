@@ -0,0 +1,123 @@
+// Runs the sketch's task set and loop() against the power manager with a
+// static frame and nobody on the AP, through idle into light sleep and back
+// on a button press. Checks which tasks run in each state, that light sleep
+// is not broken up into tiny cycles, that a press partway through a sleep
+// wakes the badge within a frame, and prints the awake time and current
+// estimate.
+
+#include <host.h>
+#include <ESP8266WiFi.h>
+#include "check.h"
+#include "power_manager.h"
+
+static const uint8_t WAKE_PIN = 5;
+
+static Scheduler scheduler;
+static PowerManager powerManager;
+static uint32_t renderRuns = 0, audioRuns = 0, remoteRuns = 0, scheduleRuns = 0, wifiRestores = 0;
+
+// Same periods as setupTasks()
+static int stateTask, outputTask, audioTask, remoteTask, otaTask, serialTask;
+
+static void setupTasks() {
+    stateTask = scheduler.addPeriodic("state", []() { renderRuns++; }, PRIORITY_RENDER, 20, 2000);
+    outputTask = scheduler.addPeriodic("output", []() { renderRuns++; }, PRIORITY_RENDER, 4, 1000);
+    audioTask = scheduler.addPeriodic("audio", []() { audioRuns++; }, PRIORITY_INPUT, 20, 150);
+    remoteTask = scheduler.addPeriodic("remote", []() { remoteRuns++; }, PRIORITY_NETWORK, 5, 1500);
+    scheduler.addPeriodic("schedule", []() { scheduleRuns++; }, PRIORITY_HOUSEKEEPING, 1000, 500);
+    otaTask = scheduler.addPeriodic("ota", []() {}, PRIORITY_HOUSEKEEPING, 20, 1000);
+    scheduler.addPeriodic("stats", []() {}, PRIORITY_HOUSEKEEPING, 10000, 3000);
+    serialTask = scheduler.addPeriodic("serial", []() {}, PRIORITY_HOUSEKEEPING, 50, 2000);
+
+    static const int WAKE_PINS[] = {WAKE_PIN};
+    powerManager.begin(scheduler, WAKE_PINS, 1, []() {
+        WiFi.mode(WIFI_AP);
+        wifiRestores++;
+    });
+    powerManager.suspendWhenIdle(stateTask);
+    powerManager.suspendWhenIdle(outputTask);
+    powerManager.suspendWhenIdle(audioTask);
+    powerManager.suspendWhileRadioOff(remoteTask);
+    powerManager.suspendWhileRadioOff(otaTask);
+    powerManager.suspendWhileRadioOff(serialTask);
+}
+
+// loop() for wallMs of wall time, the frame last changed at lastChange
+static void run(unsigned long wallMs, unsigned long lastChange) {
+    unsigned long end = host::wallMillis() + wallMs;
+    while (host::wallMillis() < end) {
+        scheduler.runOnce();
+        powerManager.update(lastChange);
+        powerManager.idle(scheduler.getIdleTimeUs());
+    }
+}
+
+int main() {
+    host::useSimulatedTime(true);
+    WiFi.mode(WIFI_AP);
+    setupTasks();
+    unsigned long lastChange = millis();
+
+    run(1000, lastChange);
+    CHECK(powerManager.getState() == PowerState::ACTIVE);
+    CHECK(WiFi.getSleepMode() == WIFI_NONE_SLEEP);
+    CHECK(renderRuns > 200);
+
+    // Static frame: render and audio stop, the radio naps between beacons
+    run(2000, lastChange);
+    CHECK(powerManager.getState() == PowerState::IDLE);
+    CHECK(WiFi.getSleepMode() == WIFI_MODEM_SLEEP);
+    uint32_t renderBefore = renderRuns, audioBefore = audioRuns, remoteBefore = remoteRuns;
+    run(10000, lastChange);
+    CHECK_EQ(renderRuns, renderBefore);
+    CHECK_EQ(audioRuns, audioBefore);
+    CHECK(remoteRuns > remoteBefore + 1000);    // Still answering the phone
+
+    // Nobody connected: radio off, network tasks stop, long light sleeps
+    run(PowerManager::SLEEP_AFTER_MS, lastChange);
+    CHECK(powerManager.getState() == PowerState::LIGHT_SLEEP);
+    CHECK(WiFi.getMode() == WIFI_OFF);
+    powerManager.resetStats();
+    remoteBefore = remoteRuns;
+    uint32_t sleepsBefore = host::lightSleepCount();
+    uint32_t scheduleBefore = scheduleRuns;
+    const unsigned long SLEEP_TEST_MS = 600000;
+    run(SLEEP_TEST_MS, lastChange);
+    uint32_t sleeps = host::lightSleepCount() - sleepsBefore;
+    CHECK_EQ(remoteRuns, remoteBefore);
+    CHECK(scheduleRuns - scheduleBefore >= SLEEP_TEST_MS / 1000 - 1);   // Schedule still checked
+    CHECK(sleeps <= SLEEP_TEST_MS / PowerManager::MIN_LIGHT_SLEEP_MS);
+    CHECK(sleeps <= 2 * SLEEP_TEST_MS / 1000);   // About one per schedule run, not one per 5 ms
+
+    const PowerStats& stats = powerManager.getStats();
+    uint64_t awakeUs = stats.awakeUs[0] + stats.awakeUs[1] + stats.awakeUs[2];
+    uint32_t averageUa = powerManager.getAverageMicroamps();
+    printf("light sleep: %u sleeps in %lu s, awake %lu ms, asleep %lu ms, ~%u uA\n", sleeps,
+           SLEEP_TEST_MS / 1000, (unsigned long)(awakeUs / 1000), (unsigned long)(stats.sleptUs / 1000),
+           averageUa);
+    CHECK(awakeUs * 100 < stats.sleptUs);   // Awake under 1% of the time
+    CHECK(averageUa < 2 * PowerManager::LIGHT_SLEEP_UA);
+    powerManager.printStats(Serial);
+
+    // A press partway through a sleep brings everything back within a frame,
+    // not when the sleep's timer would have run out
+    host::pressDuringSleep(WAKE_PIN, 300000);
+    renderBefore = renderRuns;
+    unsigned long giveUp = host::wallMillis() + 5000;
+    while (renderRuns == renderBefore && host::wallMillis() < giveUp) run(1, lastChange);
+    unsigned long wakeLatency = host::wallMillis() - host::pinWakeMillis();
+    printf("wake: first render %lu ms after the press\n", wakeLatency);
+    CHECK(renderRuns > renderBefore);
+    CHECK(wakeLatency <= 20);
+    host::setPin(WAKE_PIN, HIGH);
+    CHECK(powerManager.getState() == PowerState::ACTIVE);
+    CHECK_EQ(wifiRestores, 1);
+    CHECK(WiFi.getSleepMode() == WIFI_NONE_SLEEP);
+    renderBefore = renderRuns;
+    remoteBefore = remoteRuns;
+    run(100, lastChange);
+    CHECK(renderRuns > renderBefore);
+    CHECK(remoteRuns > remoteBefore);
+
+    return checkResult("power_states");
+}
\ No newline at end of file
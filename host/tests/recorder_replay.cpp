@@ -0,0 +1,242 @@
+// Records a long sound-reactive session with buttons and remote commands,
+// dumps it in the serial text format, loads the dump into a fresh recorder
+// and replays it. Every replayed tick must match the live one: the state,
+// the frame the OutputManager composes from it, and when it ran, so stalls
+// the live badge suffered replay with the same timing. The session wraps
+// the ring many times over, so this also checks that a keyframe always
+// survives eviction.
+
+#include <host.h>
+#include <string>
+#include <vector>
+#include "check.h"
+#include "state_manager.h"
+#include "output_manager.h"
+#include "remote_control.h"
+#include "recorder.h"
+
+static const uint32_t SESSION_TICKS = 4000;   // 80 s
+static const uint32_t STALL_EVERY = 45;         // Ticks between late ticks
+static const unsigned long STALL_MS = 140;      // How late
+
+struct Badge {
+    StateManager stateManager;
+    StateBuffer stateBuffer;
+    OutputManager outputManager;
+    PowerManager powerManager;
+    Schedule schedule;
+    RemoteControl remoteControl;
+    Recorder recorder;
+
+    Badge() {
+        recorder.begin(stateManager);
+        remoteControl.begin(stateManager, outputManager, powerManager, recorder, schedule);
+    }
+};
+
+static Badge live;
+static Badge replayed;
+
+static uint32_t stateHash(const StateManager& sm) {
+    uint32_t hash = 2166136261UL;
+    auto mix = [&hash](uint32_t value) {
+        for (int i = 0; i < 4; i++) hash = (hash ^ ((value >> (8 * i)) & 0xFF)) * 16777619UL;
+    };
+    for (int i = 0; i < StateManager::MAX_OUTPUTS; i++) {
+        OutputState user = sm.getUserState(i);
+        OutputState anim = sm.getAnimationState(i);
+        mix(user.isOn | user.hue << 8 | (uint32_t)user.brightness << 16);
+        mix(anim.isOn | anim.hue << 8 | (uint32_t)anim.brightness << 16);
+    }
+    mix(sm.getFrameCount());
+    return hash;
+}
+
+// Publish the tick and compose a frame from it, as the output task does
+static uint32_t render(Badge& badge) {
+    badge.stateManager.publish(badge.stateBuffer);
+    badge.outputManager.update();
+    uint32_t hash = 2166136261UL;
+    const Compositor& compositor = badge.outputManager.getCompositor();
+    for (int i = 0; i < Compositor::NUM_PIXELS; i++) {
+        const Rgb16Color& pixel = compositor.getPixel(i);
+        uint16_t channels[3] = {pixel.R, pixel.G, pixel.B};
+        for (uint16_t channel : channels) {
+            hash = (hash ^ (channel & 0xFF)) * 16777619UL;
+            hash = (hash ^ (channel >> 8)) * 16777619UL;
+        }
+    }
+    return hash;
+}
+
+static void press(Badge& badge, ButtonEvent type, int index) {
+    ButtonEventData event = {type, index};
+    badge.recorder.recordButton(event);
+    badge.stateManager.handleButtonEvent(event);
+}
+
+static void command(Badge& badge, uint8_t cmd, std::initializer_list<uint8_t> payload) {
+    std::vector<uint8_t> bytes(payload);
+    if (badge.remoteControl.applyCommand(cmd, bytes.data(), bytes.size()) == RemoteControl::STATUS_OK) {
+        badge.recorder.recordCommand(cmd, bytes.data(), bytes.size());
+    }
+}
+
+static void hearMusic(Badge& badge, Prng& rng, uint32_t tick) {
+    AudioFeatures features;
+    for (uint8_t& band : features.bands) band = rng.next8();
+    features.level = rng.next8();
+    features.beat = tick % 25 == 0;
+    badge.stateManager.setAudioFeatures(features);
+    badge.recorder.recordAudio(features);
+}
+
+static std::vector<std::string> dump(const Recorder& recorder) {
+    std::vector<std::string> lines;
+    char text[80];
+    snprintf(text, sizeof(text), "REC %u bytes", recorder.getSize());
+    lines.push_back(text);
+    uint8_t chunk[32];
+    for (uint16_t offset = 0;; offset += sizeof(chunk)) {
+        size_t length = recorder.read(offset, chunk, sizeof(chunk));
+        std::string line;
+        for (size_t i = 0; i < length; i++) {
+            snprintf(text, sizeof(text), "%02X", chunk[i]);
+            line += text;
+        }
+        if (length > 0) lines.push_back(line);
+        if (length < sizeof(chunk)) break;
+    }
+    lines.push_back("END");
+    return lines;
+}
+
+static Recorder::LoadResult load(Recorder& recorder, const std::vector<std::string>& lines) {
+    recorder.beginLoad();
+    Recorder::LoadResult result = Recorder::LOAD_MORE;
+    for (const std::string& line : lines) {
+        result = recorder.loadLine(line.c_str());
+        if (result != Recorder::LOAD_MORE) break;
+    }
+    return result;
+}
+
+int main(int argc, char** argv) {
+    host::useSimulatedTime(true);
+
+    // Live session, audio at the analyzer's ~78 blocks/s
+    std::vector<uint32_t> liveHashes, liveFrames;
+    std::vector<unsigned long> liveTimes;
+    uint32_t lastRecordTick = 0, stalls = 0;
+    Prng music(42);
+    live.stateManager.setRandomSeed(0xC0FFEE);
+    live.recorder.recordSeed(0xC0FFEE, 0);
+    live.stateManager.publish(live.stateBuffer);
+    live.outputManager.begin(live.stateBuffer);
+    for (uint32_t tick = 0; tick < SESSION_TICKS; tick++) {
+        if (tick == 10) press(live, ButtonEvent::DOUBLE_CLICKED, 0);
+        if (tick == 50) press(live, ButtonEvent::LONG_PRESSED, 2);
+        if (tick == 51) press(live, ButtonEvent::LONG_PRESS_RELEASED, 2);
+        if (tick % 700 == 300) press(live, ButtonEvent::CLICKED, (tick / 700) % 3);
+        if (tick == 2500) command(live, RemoteControl::CMD_SET_PATTERN, {1});
+        if (tick == 3200) command(live, RemoteControl::CMD_SET_MODE, {0x03});
+        if (tick == 3900) command(live, RemoteControl::CMD_SET_PATTERN, {7});
+
+        if (live.stateManager.isSoundReactive()) {
+            hearMusic(live, music, tick);
+            if (tick % 2 == 0) hearMusic(live, music, tick);
+            lastRecordTick = tick;
+        }
+        if (tick % STALL_EVERY == STALL_EVERY - 1) {
+            host::advanceMillis(STALL_MS);  // WiFi held the CPU
+            stalls++;
+        }
+        live.recorder.tick(millis());
+        live.stateManager.update();
+        liveHashes.push_back(stateHash(live.stateManager));
+        liveFrames.push_back(render(live));
+        liveTimes.push_back(millis());
+        host::advanceMillis(StateManager::UPDATE_INTERVAL_MS);
+    }
+    CHECK(live.stateManager.isSoundReactive());
+    CHECK(live.recorder.getSize() > Recorder::BUFFER_SIZE * 3 / 4);
+
+    // Round trip through the text format
+    std::vector<std::string> lines = dump(live.recorder);
+    if (argc > 1) {
+        // Leaves a serial log for the nametag_replay smoke test
+        FILE* log = fopen(argv[1], "w");
+        CHECK(log != nullptr);
+        if (log) {
+            fprintf(log, "Flight recorder\n");
+            for (const std::string& line : lines) fprintf(log, "%s\n", line.c_str());
+            fclose(log);
+        }
+    }
+    CHECK_EQ(load(replayed.recorder, lines), Recorder::LOAD_DONE);
+    CHECK_EQ(replayed.recorder.getSize(), live.recorder.getSize());
+    CHECK(!replayed.recorder.isEnabled());
+
+    Replayer replayer;
+    replayer.begin(replayed.recorder, replayed.stateManager,
+                   [](const ButtonEventData& event) { replayed.stateManager.handleButtonEvent(event); },
+                   [](uint8_t cmd, const uint8_t* payload, size_t length) {
+                       return replayed.remoteControl.applyCommand(cmd, payload, length);
+                   });
+    CHECK(replayer.start());
+
+    // The output task was already following the live state when the
+    // recording starts, so it starts on the first replayed tick's state
+    std::vector<uint32_t> replayHashes, replayFrames;
+    std::vector<unsigned long> replayTimes;
+    while (replayer.isRunning()) {
+        uint32_t before = replayer.getTickCount();
+        replayer.step(millis());
+        if (replayer.getTickCount() != before) {
+            if (replayHashes.empty()) {
+                replayed.stateManager.publish(replayed.stateBuffer);
+                replayed.outputManager.begin(replayed.stateBuffer);
+            }
+            replayHashes.push_back(stateHash(replayed.stateManager));
+            replayFrames.push_back(render(replayed));
+            replayTimes.push_back(millis());
+        }
+        host::advanceMillis(StateManager::UPDATE_INTERVAL_MS);
+    }
+    CHECK(replayHashes.size() > 100);
+    // The dump ends at its last record, so the replay stops short of the
+    // tick that followed it
+    CHECK(replayHashes.size() <= lastRecordTick);
+    size_t offset = lastRecordTick - replayHashes.size();
+    size_t mismatches = 0, frameMismatches = 0, timingMismatches = 0, replayedStalls = 0;
+    for (size_t i = 0; i < replayHashes.size(); i++) {
+        if (replayHashes[i] != liveHashes[offset + i]) mismatches++;
+        if (replayFrames[i] != liveFrames[offset + i]) frameMismatches++;
+        if (i == 0) continue;
+        // Tick to tick, so the replay's later start doesn't matter
+        unsigned long liveGap = liveTimes[offset + i] - liveTimes[offset + i - 1];
+        unsigned long replayGap = replayTimes[i] - replayTimes[i - 1];
+        if (replayGap != liveGap) timingMismatches++;
+        if (liveGap > StateManager::UPDATE_INTERVAL_MS) replayedStalls++;
+    }
+    CHECK_EQ(mismatches, 0);
+    CHECK_EQ(frameMismatches, 0);
+    CHECK_EQ(timingMismatches, 0);
+    CHECK(replayedStalls >= 2);
+    printf("replayed %zu of %zu ticks from a %u byte dump, %zu of %u stalls in range\n", replayHashes.size(),
+           liveHashes.size(), live.recorder.getSize(), replayedStalls, stalls);
+
+    // Broken dumps are refused and leave nothing behind
+    Recorder broken;
+    std::vector<std::string> truncated = lines;
+    truncated[truncated.size() - 2].pop_back();
+    truncated[truncated.size() - 2].pop_back();
+    CHECK_EQ(load(broken, truncated), Recorder::LOAD_FAILED);
+    CHECK_EQ(broken.getSize(), 0);
+    std::vector<std::string> garbled = lines;
+    garbled[1][5] = 'x';
+    CHECK_EQ(load(broken, garbled), Recorder::LOAD_FAILED);
+    CHECK_EQ(broken.getSize(), 0);
+
+    return checkResult("recorder_replay");
+}
\ No newline at end of file
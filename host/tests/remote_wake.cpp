@@ -0,0 +1,196 @@
+// Runs the render and network tasks with a phone on the AP and the badge
+// idle on a static frame:
+//  - pings, state queries and clock syncs are answered without waking it
+//  - a command that changes the frame reaches the strip within a couple of
+//    frames of the packet arriving, printed as wake latency
+//  - under sustained load every command is answered within a few remote
+//    polls: below the drain rate none are dropped, and above it the stack's
+//    receive queue drops the excess rather than replies falling ever
+//    further behind. Round trips are printed as p50/p99/max.
+
+#include <host.h>
+#include <algorithm>
+#include <map>
+#include <ESP8266WiFi.h>
+#include <WiFiUdp.h>
+#include "check.h"
+#include "remote_control.h"
+
+static const uint8_t WAKE_PIN = 5;
+static const IPAddress PHONE(192, 168, 4, 2);
+static const int TRIALS = 20;
+
+static StateManager stateManager;
+static StateBuffer stateBuffer;
+static OutputManager outputManager;
+static PowerManager powerManager;
+static Schedule schedule;
+static Recorder recorder;
+static RemoteControl remoteControl;
+static Scheduler scheduler;
+static uint16_t sequence = 0;
+
+// Same tasks and periods as setupTasks()
+static void setupTasks() {
+    int stateTask = scheduler.addPeriodic("state", []() {
+        stateManager.update();
+        stateManager.publish(stateBuffer);
+    }, PRIORITY_RENDER, StateManager::UPDATE_INTERVAL_MS, 2000);
+    int outputTask = scheduler.addPeriodic("output", []() { outputManager.update(); },
+                                           PRIORITY_RENDER, outputManager.getRefreshInterval(), 1000);
+    outputManager.bindTask(scheduler, outputTask);
+    scheduler.addPeriodic("remote", []() { remoteControl.poll(); }, PRIORITY_NETWORK, 5, 1500);
+
+    static const int WAKE_PINS[] = {WAKE_PIN};
+    powerManager.begin(scheduler, WAKE_PINS, 1, nullptr);
+    powerManager.suspendWhenIdle(stateTask);
+    powerManager.suspendWhenIdle(outputTask, []() { outputManager.flush(); });
+}
+
+static bool receive(uint8_t command, std::initializer_list<uint8_t> payload) {
+    host::Packet packet = {PHONE, 50000, {RemoteControl::MAGIC, command, (uint8_t)sequence, (uint8_t)(sequence >> 8)}};
+    packet.data.insert(packet.data.end(), payload);
+    sequence++;
+    return host::deliver(packet);
+}
+
+// One pass of loop()
+static void pass() {
+    scheduler.runOnce();
+    powerManager.update(outputManager.getLastFrameChange());
+    powerManager.idle(scheduler.getIdleTimeUs());
+}
+
+// loop() for up to ms, or until done() says stop
+template <typename Done>
+static void run(unsigned long ms, Done done) {
+    unsigned long start = millis();
+    while (millis() - start < ms && !done()) pass();
+}
+
+static void run(unsigned long ms) {
+    run(ms, []() { return false; });
+}
+
+static long percentile(std::vector<long> values, int percent) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    return values[(values.size() - 1) * percent / 100];
+}
+
+// A phone sending perSecond commands, evenly spaced, for ms: state queries
+// and output changes. Times every reply from when its command was sent.
+struct Burst {
+    uint32_t sent, replied, dropped;
+    long p50Us, p99Us, maxUs;
+};
+
+static Burst burst(uint32_t perSecond, unsigned long ms) {
+    size_t firstReply = host::udpOutbox().size();
+    uint32_t droppedBefore = host::udpDropped();
+    std::map<uint16_t, unsigned long> sentAt;
+    unsigned long start = micros(), intervalUs = 1000000UL / perSecond;
+    uint32_t sent = 0;
+    while (micros() - start < ms * 1000) {
+        // Everything due by now, in case the last pass slept through several
+        for (; sent * intervalUs <= micros() - start; sent++) {
+            sentAt[sequence] = start + sent * intervalUs;
+            if (sent % 3 == 0) {
+                receive(RemoteControl::CMD_GET_STATE, {});
+            } else {
+                receive(RemoteControl::CMD_SET_OUTPUT, {(uint8_t)(sent % StateManager::MAX_OUTPUTS),
+                                                        (uint8_t)(sent % 2), (uint8_t)sent, 0xFF, 0xFF});
+            }
+        }
+        pass();
+    }
+    run(200);   // Drain
+
+    Burst result = {sent, 0, host::udpDropped() - droppedBefore, 0, 0, 0};
+    std::vector<long> roundTrips;
+    for (size_t i = firstReply; i < host::udpOutbox().size(); i++) {
+        const host::Packet& reply = host::udpOutbox()[i];
+        if (reply.data[1] == RemoteControl::CMD_FRAME) continue;
+        CHECK_EQ(reply.data[4], RemoteControl::STATUS_OK);
+        uint16_t seq = reply.data[2] | reply.data[3] << 8;
+        roundTrips.push_back((long)(reply.timeUs - sentAt[seq]));
+        result.replied++;
+    }
+    result.p50Us = percentile(roundTrips, 50);
+    result.p99Us = percentile(roundTrips, 99);
+    result.maxUs = percentile(roundTrips, 100);
+    printf("%u commands/s for %lu ms: %u sent, %u answered, %u dropped, round trip p50 %ld us, p99 %ld us, "
+           "max %ld us\n", perSecond, ms, result.sent, result.replied, result.dropped, result.p50Us,
+           result.p99Us, result.maxUs);
+    return result;
+}
+
+int main() {
+    host::useSimulatedTime(true);
+    WiFi.mode(WIFI_AP);
+    host::stationCount = 1;     // Keeps the badge from light sleep
+    stateManager.publish(stateBuffer);
+    outputManager.begin(stateBuffer);
+    recorder.begin(stateManager);
+    remoteControl.begin(stateManager, outputManager, powerManager, recorder, schedule);
+    remoteControl.listen();
+    setupTasks();
+
+    run(PowerManager::IDLE_AFTER_MS + 500);
+    CHECK(powerManager.getState() == PowerState::IDLE);
+
+    // A phone polling the badge
+    uint32_t shows = host::showCount();
+    size_t replies = host::udpOutbox().size();
+    for (int i = 0; i < 50; i++) {
+        receive(RemoteControl::CMD_PING, {});
+        receive(RemoteControl::CMD_GET_STATE, {});
+        if (i % 10 == 0) receive(RemoteControl::CMD_SET_TIME, {0x10, 0x0E, 0, 0});
+        run(100);
+    }
+    CHECK(powerManager.getState() == PowerState::IDLE);
+    CHECK_EQ(host::showCount(), shows);
+    CHECK_EQ(host::udpOutbox().size(), replies + 105);
+
+    // Rejected commands change nothing either
+    receive(RemoteControl::CMD_SET_OUTPUT, {StateManager::MAX_OUTPUTS, 1, 0, 0, 1});
+    run(100);
+    CHECK(powerManager.getState() == PowerState::IDLE);
+
+    // Toggle an output from IDLE and time it to the strip
+    unsigned long worstUs = 0, totalUs = 0;
+    for (int trial = 0; trial < TRIALS; trial++) {
+        bool on = trial % 2 == 0;
+        host::advanceMillis(trial % 5);     // Arrive at a different point in the remote task's period
+        std::string before = host::frameLine();
+        unsigned long sent = micros();
+        receive(RemoteControl::CMD_SET_OUTPUT, {0, (uint8_t)on, 0, 0xFF, 0xFF});
+        run(500, [&before]() { return host::frameLine() != before; });
+        unsigned long latencyUs = micros() - sent;
+        CHECK(host::frameLine() != before);
+        if (latencyUs > worstUs) worstUs = latencyUs;
+        totalUs += latencyUs;
+
+        run(PowerManager::IDLE_AFTER_MS + 500);
+        CHECK(powerManager.getState() == PowerState::IDLE);
+    }
+    printf("wake latency over %d commands: %lu us average, %lu us worst\n", TRIALS, totalUs / TRIALS, worstUs);
+    // A remote poll, then a state tick and a refresh
+    CHECK(worstUs <= (5 + StateManager::UPDATE_INTERVAL_MS + OutputManager::STANDARD_REFRESH_MS) * 1000UL);
+
+    // Sustained load. The remote task drains MAX_PACKETS_PER_POLL every 5 ms
+    // poll; it can be held back through one render besides.
+    const uint32_t DRAIN_PER_S = RemoteControl::MAX_PACKETS_PER_POLL * 1000 / 5;
+    const long POLL_US = 5000 + OutputManager::STANDARD_REFRESH_MS * 1000L;
+    Burst below = burst(DRAIN_PER_S / 2, 2000);
+    CHECK_EQ(below.dropped, 0);
+    CHECK_EQ(below.replied, below.sent);
+    CHECK(below.maxUs <= POLL_US);
+    Burst above = burst(DRAIN_PER_S * 3 / 2, 2000);
+    CHECK(above.dropped > 0);
+    CHECK_EQ(above.replied + above.dropped, above.sent);
+    // A full queue takes UDP_RX_QUEUE / MAX_PACKETS_PER_POLL polls to answer
+    CHECK(above.maxUs <= (long)(host::UDP_RX_QUEUE / RemoteControl::MAX_PACKETS_PER_POLL) * 5000 + POLL_US);
+
+    return checkResult("remote_wake");
+}
\ No newline at end of file
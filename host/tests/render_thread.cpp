@@ -0,0 +1,149 @@
+// Runs the state tick and the renderer on separate threads, the way a
+// dual-core port would (USE_RENDER_THREAD), and checks that nothing they
+// share tears:
+//  - every snapshot the reader takes is whole and never older than the last
+//  - every frame the network side streams is one composited frame
+//  - the last frame change time never goes backwards
+// Also reports how late the paced render thread wakes up.
+
+#include <host.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "check.h"
+#include "output_manager.h"
+
+using Clock = std::chrono::steady_clock;
+
+static const uint32_t HANDOFF_PUBLISHES = 2000000;
+static const auto PIPELINE_RUN_TIME = std::chrono::milliseconds(1500);
+static const auto STATE_TICK = std::chrono::milliseconds(2);    // 10x the device, for more handoffs
+
+static StateBuffer handoff;
+static StateManager stateManager;
+static StateBuffer stateBuffer;
+static OutputManager outputManager;
+
+// Writer stamps every field the check reads with the same sequence number
+static void stamp(StateSnapshot& snapshot, uint32_t sequence) {
+    snapshot.frameCount = sequence;
+    snapshot.masterBrightness = sequence;
+    for (int i = 0; i < StateManager::MAX_OUTPUTS; i++) {
+        snapshot.outputs.hue[i] = sequence + i;
+        snapshot.outputs.brightness[i] = sequence;
+    }
+}
+
+static bool isWhole(const StateSnapshot& snapshot) {
+    uint32_t sequence = snapshot.frameCount;
+    if (snapshot.masterBrightness != (uint8_t)sequence) return false;
+    for (int i = 0; i < StateManager::MAX_OUTPUTS; i++) {
+        if (snapshot.outputs.hue[i] != (uint8_t)(sequence + i)) return false;
+        if (snapshot.outputs.brightness[i] != (uint16_t)sequence) return false;
+    }
+    return true;
+}
+
+static void testHandoff() {
+    stamp(handoff.writeBuffer(), 0);
+    handoff.publish();
+
+    std::atomic<bool> done{false};
+    std::thread writer([&done]() {
+        for (uint32_t sequence = 1; sequence <= HANDOFF_PUBLISHES; sequence++) {
+            stamp(handoff.writeBuffer(), sequence);
+            handoff.publish();
+        }
+        done.store(true);
+    });
+
+    uint32_t reads = 0, torn = 0, backwards = 0, last = 0;
+    while (!done.load()) {
+        const StateSnapshot& snapshot = handoff.read();
+        if (!isWhole(snapshot)) torn++;
+        if (snapshot.frameCount < last) backwards++;
+        last = snapshot.frameCount;
+        reads++;
+    }
+    writer.join();
+    last = handoff.read().frameCount;
+
+    printf("handoff: %u reads of %u publishes\n", reads, HANDOFF_PUBLISHES);
+    CHECK_EQ(torn, 0);
+    CHECK_EQ(backwards, 0);
+    CHECK_EQ(last, HANDOFF_PUBLISHES);
+}
+
+static void testPipeline() {
+    stateManager.publish(stateBuffer);
+    outputManager.begin(stateBuffer);
+    outputManager.setRefreshMode(RefreshMode::FAST);
+    const auto refresh = std::chrono::milliseconds(outputManager.getRefreshInterval());
+    const Clock::time_point end = Clock::now() + PIPELINE_RUN_TIME;
+
+    // State tick: all outputs one color, a new one every tick
+    std::thread state([end]() {
+        Clock::time_point next = Clock::now();
+        for (uint32_t tick = 0; Clock::now() < end; tick++) {
+            for (int i = 0; i < StateManager::MAX_OUTPUTS; i++) {
+                stateManager.setOutput(i, true, tick * 3, 0x4000 + (tick & 0xFF) * 64);
+            }
+            stateManager.setMasterBrightness(128 + (tick & 0x7F));
+            stateManager.update();
+            stateManager.publish(stateBuffer);
+            next += STATE_TICK;
+            std::this_thread::sleep_until(next);
+        }
+    });
+
+    std::vector<long> lateUs;
+    lateUs.reserve(PIPELINE_RUN_TIME / refresh + 1);
+    std::thread render([end, refresh, &lateUs]() {
+        Clock::time_point next = Clock::now();
+        while (Clock::now() < end) {
+            outputManager.update();
+            next += refresh;
+            std::this_thread::sleep_until(next);
+            lateUs.push_back(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - next).count());
+        }
+    });
+
+    // This thread plays the network task
+    uint32_t frames = 0, torn = 0, backwards = 0;
+    unsigned long lastChange = 0;
+    while (Clock::now() < end) {
+        const Frame& frame = outputManager.readFrame();
+        for (int i = 1; i < Compositor::NUM_PIXELS; i++) {
+            const Rgb16Color& a = frame.pixels[0];
+            const Rgb16Color& b = frame.pixels[i];
+            if (a.R != b.R || a.G != b.G || a.B != b.B) {
+                torn++;
+                break;
+            }
+        }
+        unsigned long change = outputManager.getLastFrameChange();
+        if (change < lastChange) backwards++;
+        lastChange = change;
+        frames++;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    state.join();
+    render.join();
+
+    std::sort(lateUs.begin(), lateUs.end());
+    size_t count = lateUs.size();
+    printf("pipeline: %u frame reads, %zu refreshes, late by median %ld us, p99 %ld us, max %ld us\n",
+           frames, count, lateUs[count / 2], lateUs[count * 99 / 100], lateUs[count - 1]);
+    CHECK_EQ(torn, 0);
+    CHECK_EQ(backwards, 0);
+    CHECK(lastChange > 0);
+    CHECK(lateUs[count / 2] < (long)outputManager.getRefreshInterval() * 1000);
+}
+
+int main() {
+    testHandoff();
+    testPipeline();
+    return checkResult("render_thread");
+}
\ No newline at end of file
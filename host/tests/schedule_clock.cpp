@@ -0,0 +1,190 @@
+// Fast-forwards the schedule through whole days and a badge through a
+// night of blackout sleep:
+//  - evaluateAt() never changes before secondsUntilChangeAt() said it may,
+//    so the badge can sleep that long without missing anything
+//  - overnight windows, party hours and ramp steps land where expected
+//  - the power manager's clock keeps counting through forced light sleep
+//    (RTC compensated), so the sketch's schedule runner ends a blackout on
+//    time
+//  - a remote brightness command holds until the schedule's own level
+//    changes, with no rule or through a fast-forwarded day
+
+#include <host.h>
+#include "check.h"
+#include "schedule.h"
+#include "power_manager.h"
+#include "schedule_runner.h"
+
+static const uint32_t DAY = Schedule::SECONDS_PER_DAY;
+
+static bool sameState(const ScheduleState& a, const ScheduleState& b) {
+    return a.blackout == b.blackout && a.party == b.party && a.brightness == b.brightness;
+}
+
+static uint32_t at(int hour, int minute, int second = 0) {
+    return hour * 3600UL + minute * 60UL + second;
+}
+
+static void testFastForward() {
+    Schedule schedule;  // Default blackout 23:00-07:00
+    CHECK(schedule.setRule(1, {ScheduleAction::PARTY, 18 * 60, 20 * 60, 0, 0}));
+    CHECK(schedule.setRule(2, {ScheduleAction::BRIGHTNESS, 20 * 60, 23 * 60, 255, 32}));
+    CHECK(schedule.setRule(3, {ScheduleAction::PARTY, 22 * 60 + 30, 30, 0, 0}));     // Over midnight
+    CHECK(schedule.setRule(4, {ScheduleAction::BRIGHTNESS, 9 * 60, 9 * 60 + 7, 10, 200}));
+
+    // Jump from change to change the way the badge sleeps, and check every
+    // second in between
+    uint32_t jumps = 0, changes = 0;
+    for (uint32_t second = 0; second < DAY; jumps++) {
+        ScheduleState state = schedule.evaluateAt(second);
+        uint32_t until = schedule.secondsUntilChangeAt(second);
+        CHECK(until > 0 && until <= DAY);
+        uint32_t early = 0;
+        for (uint32_t s = second + 1; s < second + until; s++) {
+            if (!sameState(schedule.evaluateAt(s % DAY), state)) early++;
+        }
+        CHECK_EQ(early, 0);
+        if (!sameState(schedule.evaluateAt((second + until) % DAY), state)) changes++;
+        second += until;
+    }
+    printf("schedule: %u jumps, %u changes in a day\n", jumps, changes);
+    CHECK(jumps < 300);    // Not one per second
+
+    // Windows
+    CHECK(schedule.evaluateAt(at(22, 59, 59)).party);
+    CHECK(!schedule.evaluateAt(at(22, 59, 59)).blackout);
+    CHECK(schedule.evaluateAt(at(23, 0)).blackout);
+    CHECK_EQ(schedule.evaluateAt(at(23, 0)).brightness, 0);
+    CHECK(schedule.evaluateAt(at(0, 29, 59)).party);
+    CHECK(!schedule.evaluateAt(at(0, 30)).party);
+    CHECK(schedule.evaluateAt(at(6, 59, 59)).blackout);
+    CHECK(!schedule.evaluateAt(at(7, 0)).blackout);
+    CHECK(schedule.evaluateAt(at(19, 0)).party);
+    CHECK(!schedule.evaluateAt(at(20, 0)).party);
+    CHECK_EQ(schedule.secondsUntilChangeAt(at(23, 0)), 90 * 60);    // Party ends at 00:30
+
+    // Ramps hold for a whole step, then move
+    CHECK_EQ(schedule.evaluateAt(at(20, 0)).brightness, 255);
+    CHECK_EQ(schedule.evaluateAt(at(20, 0, 59)).brightness, 255);
+    CHECK(schedule.evaluateAt(at(20, 1)).brightness < 255);
+    CHECK_EQ(schedule.evaluateAt(at(21, 30)).brightness, 255 - (255 - 32) / 2);
+    CHECK_EQ(schedule.secondsUntilChangeAt(at(21, 30, 20)), 40);
+    CHECK_EQ(schedule.evaluateAt(at(9, 6, 59)).brightness, 10 + 190 * 6 / 7);
+    CHECK_EQ(schedule.evaluateAt(at(9, 7)).brightness, 255);
+
+    // A whole week through the millis() clock
+    schedule.setTime(at(12, 0), 5000);
+    for (uint32_t day = 0; day < 7; day++) {
+        unsigned long midnight = 5000 + (day * DAY + at(12, 0)) * 1000UL;
+        CHECK(schedule.evaluate(midnight + at(23, 30) * 1000UL).blackout);
+        CHECK(!schedule.evaluate(midnight + at(7, 0) * 1000UL).blackout);
+    }
+}
+
+// The sketch's schedule task and everything it drives
+struct Badge {
+    Scheduler scheduler;
+    StateManager stateManager;
+    OutputManager outputManager;
+    PowerManager powerManager;
+    Schedule schedule;
+    RemoteControl remoteControl;
+    Recorder recorder;
+    ScheduleRunner runner;
+
+    Badge() {
+        static const int WAKE_PINS[] = {5};
+        powerManager.begin(scheduler, WAKE_PINS, 1, nullptr);
+        recorder.begin(stateManager);
+        remoteControl.begin(stateManager, outputManager, powerManager, recorder, schedule);
+        runner.begin(schedule, stateManager, powerManager, remoteControl, recorder);
+    }
+
+    void setBrightness(uint8_t level) {
+        remoteControl.applyCommand(RemoteControl::CMD_SET_BRIGHTNESS, &level, 1);
+    }
+
+    // A schedule task run every second for seconds
+    void fastForward(uint32_t seconds) {
+        for (uint32_t i = 0; i < seconds; i++) {
+            runner.update();
+            host::advanceMillis(1000);
+        }
+    }
+};
+
+static void testBlackoutClock() {
+    host::useSimulatedTime(true);
+    Badge badge;
+    PowerManager& powerManager = badge.powerManager;
+    badge.schedule.setTime(at(22, 59, 50), powerManager.clockMs());
+    unsigned long wallStart = host::wallMillis();
+    unsigned long millisStart = millis();
+
+    // The schedule task, then the power manager after the pass
+    uint32_t sleeps = 0;
+    bool wasBlackout = false;
+    unsigned long blackoutEnded = 0;
+    while (host::wallMillis() - wallStart < 9 * 3600 * 1000UL) {
+        badge.runner.update();
+        if (wasBlackout && !powerManager.isInBlackout() && blackoutEnded == 0) {
+            blackoutEnded = host::wallMillis() - wallStart;
+        }
+        wasBlackout = powerManager.isInBlackout();
+        powerManager.update(0);
+        if (powerManager.isInBlackout()) sleeps++;
+        powerManager.idle(1000000);
+    }
+
+    printf("blackout: ended %lu ms in, %u sleeps, millis() saw %lu ms of %lu\n", blackoutEnded, sleeps,
+           millis() - millisStart, host::wallMillis() - wallStart);
+    // 10 s to 23:00 and a second for the dark frame, 8 h dark; the schedule
+    // task then needs up to a second
+    CHECK(blackoutEnded >= (10 + 8 * 3600) * 1000UL);
+    CHECK(blackoutEnded <= (13 + 8 * 3600) * 1000UL);
+    CHECK_EQ(badge.stateManager.getMasterBrightness(), 255);
+    CHECK(sleeps < 8 * 3600 / (PowerManager::MAX_BLACKOUT_SLEEP_MS / 1000) + 10);
+    CHECK(millis() - millisStart < 3600 * 1000UL);      // Most of the night went unseen
+    long drift = (long)(powerManager.clockMs() - millisStart) - (long)(host::wallMillis() - wallStart);
+    CHECK(drift > -100 && drift < 100);
+}
+
+// A phone's brightness holds until the schedule next changes its mind
+static void testRemoteBrightness() {
+    host::useSimulatedTime(true);
+
+    // No clock, then a clock with no brightness rule: nothing to undo it
+    Badge badge;
+    badge.fastForward(5);
+    badge.setBrightness(40);
+    badge.fastForward(60);
+    CHECK_EQ(badge.stateManager.getMasterBrightness(), 40);
+    badge.schedule.setTime(at(8, 0), badge.powerManager.clockMs());
+    badge.fastForward(10 * 3600);
+    CHECK_EQ(badge.stateManager.getMasterBrightness(), 40);
+
+    // Through a blackout: dark overnight, then back to the schedule's level
+    badge.fastForward(6 * 3600);
+    CHECK(badge.powerManager.isInBlackout());
+    CHECK_EQ(badge.stateManager.getMasterBrightness(), 0);
+
+    // A ramp takes over again at its next step
+    Badge ramped;
+    CHECK(ramped.schedule.setRule(1, {ScheduleAction::BRIGHTNESS, 12 * 60, 14 * 60, 200, 80}));
+    ramped.schedule.setTime(at(12, 30, 10), ramped.powerManager.clockMs());
+    ramped.fastForward(1);
+    uint8_t level = ramped.schedule.evaluateAt(at(12, 30, 10)).brightness;
+    CHECK_EQ(ramped.stateManager.getMasterBrightness(), level);
+    ramped.setBrightness(255);
+    ramped.fastForward(45);
+    CHECK_EQ(ramped.stateManager.getMasterBrightness(), 255);
+    ramped.fastForward(10);
+    CHECK_EQ(ramped.stateManager.getMasterBrightness(), ramped.schedule.evaluateAt(at(12, 31)).brightness);
+}
+
+int main() {
+    testFastForward();
+    testBlackoutClock();
+    testRemoteBrightness();
+    return checkResult("schedule_clock");
+}
\ No newline at end of file
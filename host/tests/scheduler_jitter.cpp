@@ -0,0 +1,166 @@
+// Simulates the sketch's task set with realistic run times (some of them
+// over budget now and then) and measures how late each task starts, both
+// with the microphone off and while listening (audio sampling every 200 us,
+// blocks analyzed as they fill, the strip at the STANDARD refresh):
+//  - renders start within a small margin of their deadline, whatever the
+//    network and housekeeping tasks are doing
+//  - a held back task waits for one render at most, so nothing starves,
+//    and only the task that would have run counts as held back
+//  - capture fills most sample slots itself, whatever else is running
+//  - idle time is never reported while a task is actually runnable
+
+#include <host.h>
+#include <algorithm>
+#include <vector>
+#include <string.h>
+#include "check.h"
+#include "scheduler.h"
+#include "prng.h"
+
+static const unsigned long RUN_US = 60UL * 1000000;     // One simulated minute
+
+struct SimTask {
+    const char* name;
+    TaskPriority priority;
+    unsigned long periodUs;
+    unsigned long budgetUs;
+    unsigned long costUs;       // Typical run time
+    uint8_t overrunPercent;     // Runs that take 3x costUs
+    int id;
+    std::vector<long> lateUs;
+};
+
+static Scheduler* scheduler;
+static Prng rng(7);
+static SimTask quietTasks[] = {
+    {"state", PRIORITY_RENDER, 20000, 2000, 1200, 0},
+    {"output", PRIORITY_RENDER, 4000, 1000, 600, 0},
+    {"buttons", PRIORITY_INPUT, 2000, 500, 60, 0},
+    {"audio", PRIORITY_INPUT, 20000, 150, 10, 0},    // Checks the mode once a tick
+    {"remote", PRIORITY_NETWORK, 5000, 1500, 300, 5},
+    {"schedule", PRIORITY_HOUSEKEEPING, 1000000, 500, 100, 0},
+    {"ota", PRIORITY_HOUSEKEEPING, 20000, 1000, 200, 10},
+    {"stats", PRIORITY_HOUSEKEEPING, 10000000, 3000, 2500, 0},
+    {"serial", PRIORITY_HOUSEKEEPING, 50000, 2000, 150, 0},
+};
+static SimTask listeningTasks[] = {
+    {"state", PRIORITY_RENDER, 20000, 2000, 1200, 0},
+    {"output", PRIORITY_RENDER, 20000, 1000, 600, 0},
+    {"buttons", PRIORITY_INPUT, 2000, 500, 60, 0},
+    {"audio", PRIORITY_INPUT, 200, 150, 40, 0},      // One analogRead()
+    {"analyze", PRIORITY_INPUT, 12800, 1500, 600, 2},   // An event per block in the sketch
+    {"remote", PRIORITY_NETWORK, 5000, 1500, 300, 5},
+    {"schedule", PRIORITY_HOUSEKEEPING, 1000000, 500, 100, 0},
+    {"ota", PRIORITY_HOUSEKEEPING, 20000, 1000, 200, 10},
+    {"stats", PRIORITY_HOUSEKEEPING, 10000000, 3000, 2500, 0},
+    {"serial", PRIORITY_HOUSEKEEPING, 50000, 2000, 150, 0},
+};
+static SimTask* simTasks;
+static int running = -1;
+
+static void runSimTask() {
+    SimTask& sim = simTasks[running];
+    const Task& task = scheduler->getTask(sim.id);
+    sim.lateUs.push_back((long)(micros() - task.nextRunUs));
+    unsigned long cost = sim.costUs;
+    if (rng.next8(100) < sim.overrunPercent) cost *= 3;
+    host::advanceMicros(cost);
+}
+
+// Task functions take no arguments, so one trampoline per slot
+template <int N>
+static void trampoline() {
+    running = N;
+    runSimTask();
+}
+static const TaskFunction TRAMPOLINES[] = {trampoline<0>, trampoline<1>, trampoline<2>, trampoline<3>,
+                                           trampoline<4>, trampoline<5>, trampoline<6>, trampoline<7>,
+                                           trampoline<8>, trampoline<9>};
+
+static long percentile(std::vector<long> values, int percent) {
+    std::sort(values.begin(), values.end());
+    return values[(values.size() - 1) * percent / 100];
+}
+
+static const SimTask& find(SimTask* tasks, int count, const char* name) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(tasks[i].name, name) == 0) return tasks[i];
+    }
+    return tasks[0];
+}
+
+static void simulate(const char* scenario, SimTask* tasks, int count) {
+    Scheduler sched;
+    scheduler = &sched;
+    simTasks = tasks;
+    for (int i = 0; i < count; i++) {
+        SimTask& sim = tasks[i];
+        sim.id = sched.addPeriodic(sim.name, TRAMPOLINES[i], sim.priority, 1, sim.budgetUs);
+        sched.setPeriodUs(sim.id, sim.periodUs);
+    }
+
+    // loop(): a pass, then sleep for whatever idle time is reported
+    unsigned long start = micros();
+    uint32_t idlePasses = 0, spuriousIdle = 0;
+    while (micros() - start < RUN_US) {
+        unsigned long before = micros();
+        sched.runOnce();
+        if (micros() != before) continue;
+        unsigned long idleUs = sched.getIdleTimeUs();
+        if (idleUs == 0) {
+            spuriousIdle++;    // Nothing ran, yet nothing to wait for
+            host::advanceMicros(10);
+        } else {
+            host::advanceMicros(idleUs);
+            idlePasses++;
+        }
+    }
+
+    printf("%s\n%-10s %8s %8s %8s %8s %8s\n", scenario, "task", "runs", "p50_us", "p99_us", "max_us", "defer");
+    for (int i = 0; i < count; i++) {
+        const SimTask& sim = tasks[i];
+        printf("%-10s %8zu %8ld %8ld %8ld %8u\n", sim.name, sim.lateUs.size(), percentile(sim.lateUs, 50),
+               percentile(sim.lateUs, 99), percentile(sim.lateUs, 100),
+               (unsigned)sched.getTask(sim.id).deferrals);
+    }
+    printf("%u idle passes, %u with nothing runnable\n\n", idlePasses, spuriousIdle);
+
+    // Renders: late only by whatever was already running (the worst
+    // in-budget task, or an overrun) plus the other render task. At the
+    // same period, output always follows state, showing the tick it just
+    // published.
+    const SimTask& state = find(tasks, count, "state");
+    const SimTask& output = find(tasks, count, "output");
+    unsigned long behindState = output.periodUs == state.periodUs ? state.costUs : 0;
+    CHECK(percentile(output.lateUs, 50) <= (long)(behindState + 100));
+    CHECK(percentile(output.lateUs, 99) <= 1200 + 600);
+    CHECK(output.lateUs.size() >= RUN_US / output.periodUs * 99 / 100);
+
+    // Everyone else: held back through one render at most. Capture runs
+    // so often that every render and analysis costs it a few slots, which
+    // AudioInput holds the last sample through.
+    for (int i = 0; i < count; i++) {
+        const SimTask& sim = tasks[i];
+        if (sim.priority == PRIORITY_RENDER) continue;
+        bool capture = sim.periodUs < 1000;
+        CHECK(sim.lateUs.size() >= RUN_US / sim.periodUs * (capture ? 80 : 90) / 100);   // Late runs resync
+        CHECK(percentile(sim.lateUs, 100) < (long)(2 * output.periodUs + 3 * 2500));
+    }
+    // At the FAST refresh stats rarely fits before a render, still runs
+    const SimTask& stats = find(tasks, count, "stats");
+    CHECK(stats.lateUs.size() >= 5);
+    if (output.periodUs < 2 * stats.budgetUs) CHECK(sched.getTask(stats.id).deferrals > 0);
+
+    // Losing to a render on priority isn't being held back: audio is due
+    // with the state tick, and fits before the next render once it's done
+    const SimTask& audio = find(tasks, count, "audio");
+    CHECK(sched.getTask(audio.id).deferrals < audio.lateUs.size() / 100);
+    CHECK(spuriousIdle < idlePasses / 100);
+}
+
+int main() {
+    host::useSimulatedTime(true);
+    simulate("quiet", quietTasks, sizeof(quietTasks) / sizeof(quietTasks[0]));
+    simulate("listening", listeningTasks, sizeof(listeningTasks) / sizeof(listeningTasks[0]));
+    return checkResult("scheduler_jitter");
+}
\ No newline at end of file
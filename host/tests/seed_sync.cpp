@@ -0,0 +1,127 @@
+// Shares a pattern seed between badges over the remote protocol:
+//  - SET_SEED wakes an idle badge and hands it the seed and frame number
+//  - a short payload is rejected and leaves the seed alone
+//  - two badges that start the sparkle pattern together, one of them on
+//    the other's seed, render the same frames; a third on its own seed
+//    does not
+
+#include <host.h>
+#include <ESP8266WiFi.h>
+#include <WiFiUdp.h>
+#include "check.h"
+#include "remote_control.h"
+
+static const uint8_t WAKE_PIN = 5;
+static const IPAddress PHONE(192, 168, 4, 2);
+static const uint8_t SPARKLE = 3;
+static const int TICKS = 200;
+
+static StateManager stateManager;
+static StateBuffer stateBuffer;
+static OutputManager outputManager;
+static PowerManager powerManager;
+static Schedule schedule;
+static Recorder recorder;
+static RemoteControl remoteControl;
+static Scheduler scheduler;
+static uint16_t sequence = 0;
+
+static StateManager peer, joiner, stranger;
+static RemoteControl joinerRemote;
+
+// Same tasks and periods as setupTasks()
+static void setupTasks() {
+    int stateTask = scheduler.addPeriodic("state", []() {
+        stateManager.update();
+        stateManager.publish(stateBuffer);
+    }, PRIORITY_RENDER, StateManager::UPDATE_INTERVAL_MS, 2000);
+    int outputTask = scheduler.addPeriodic("output", []() { outputManager.update(); },
+                                           PRIORITY_RENDER, outputManager.getRefreshInterval(), 1000);
+    outputManager.bindTask(scheduler, outputTask);
+    scheduler.addPeriodic("remote", []() { remoteControl.poll(); }, PRIORITY_NETWORK, 5, 1500);
+
+    static const int WAKE_PINS[] = {WAKE_PIN};
+    powerManager.begin(scheduler, WAKE_PINS, 1, nullptr);
+    powerManager.suspendWhenIdle(stateTask);
+    powerManager.suspendWhenIdle(outputTask, []() { outputManager.flush(); });
+}
+
+static void receive(uint8_t command, std::initializer_list<uint8_t> payload) {
+    host::Packet packet = {PHONE, 50000, {RemoteControl::MAGIC, command, (uint8_t)sequence, (uint8_t)(sequence >> 8)}};
+    packet.data.insert(packet.data.end(), payload);
+    host::deliver(packet);
+    sequence++;
+}
+
+static void run(unsigned long ms) {
+    unsigned long start = millis();
+    while (millis() - start < ms) {
+        scheduler.runOnce();
+        powerManager.update(outputManager.getLastFrameChange());
+        powerManager.idle(scheduler.getIdleTimeUs());
+    }
+}
+
+static bool sameFrame(const StateManager& a, const StateManager& b) {
+    for (int i = 0; i < StateManager::MAX_OUTPUTS; i++) {
+        OutputState x = a.getAnimationState(i), y = b.getAnimationState(i);
+        if (x.isOn != y.isOn || x.hue != y.hue || x.brightness != y.brightness) return false;
+    }
+    return true;
+}
+
+int main() {
+    host::useSimulatedTime(true);
+    WiFi.mode(WIFI_AP);
+    host::stationCount = 1;     // Keeps the badge from light sleep
+    stateManager.publish(stateBuffer);
+    outputManager.begin(stateBuffer);
+    recorder.begin(stateManager);
+    remoteControl.begin(stateManager, outputManager, powerManager, recorder, schedule);
+    remoteControl.listen();
+    setupTasks();
+
+    run(PowerManager::IDLE_AFTER_MS + 500);
+    CHECK(powerManager.getState() == PowerState::IDLE);
+
+    // A mesh peer's seed and frame number take over the random patterns
+    receive(RemoteControl::CMD_SET_SEED, {0xEF, 0xBE, 0xAD, 0xDE, 100, 0, 0, 0});
+    run(10);
+    CHECK(powerManager.getState() == PowerState::ACTIVE);
+    CHECK_EQ(stateManager.getRandomSeed(), 0xDEADBEEF);
+    CHECK(stateManager.getFrameCount() >= 100 && stateManager.getFrameCount() < 110);
+
+    receive(RemoteControl::CMD_SET_SEED, {0x01, 0x02, 0x03});
+    run(10);
+    const host::Packet& reply = host::udpOutbox().back();
+    CHECK_EQ(reply.data[1], RemoteControl::CMD_SET_SEED);
+    CHECK_EQ(reply.data[4], RemoteControl::STATUS_BAD_REQUEST);
+    CHECK_EQ(stateManager.getRandomSeed(), 0xDEADBEEF);
+
+    // Badges that start sparkling together, the joiner on the peer's seed
+    joinerRemote.begin(joiner, outputManager, powerManager, recorder, schedule);
+    peer.setRandomSeed(0xDEADBEEF);
+    joiner.setRandomSeed(0x1234);
+    stranger.setRandomSeed(0x1234);
+    receive(RemoteControl::CMD_SET_SEED, {0xEF, 0xBE, 0xAD, 0xDE, 0, 0, 0, 0});
+    joinerRemote.poll();
+    CHECK_EQ(joiner.getRandomSeed(), 0xDEADBEEF);
+
+    StateManager* badges[] = {&peer, &joiner, &stranger};
+    for (StateManager* badge : badges) {
+        badge->toggleAnimationMode();
+        badge->setAnimationPattern(SPARKLE);
+    }
+    int inStep = 0, strangerInStep = 0;
+    for (int tick = 0; tick < TICKS; tick++) {
+        for (StateManager* badge : badges) badge->update();
+        if (sameFrame(peer, joiner)) inStep++;
+        if (sameFrame(peer, stranger)) strangerInStep++;
+    }
+    printf("%d of %d frames in step with the peer's seed, %d on a badge's own seed\n", inStep, TICKS,
+           strangerInStep);
+    CHECK_EQ(inStep, TICKS);
+    CHECK(strangerInStep < TICKS / 2);
+
+    return checkResult("seed_sync");
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+// Builds with STATIC_ALLOCATION_MODE and malloc() wrapped, as config.h
+// describes, and allocates every way the sketch or the core could:
+//  - nothing is counted before the heap is locked
+//  - afterwards malloc, calloc, realloc and every form of new are counted,
+//    the way Arduino String's buffers would be
+//  - over-aligned new hands back aligned memory that deletes cleanly
+
+#include <host.h>
+#include <new>
+#include <stdlib.h>
+#include "check.h"
+#include "memory_monitor.h"
+
+struct alignas(64) CacheLine {
+    uint8_t bytes[64];
+};
+
+// Escapes every pointer so the compiler can't drop an allocation it sees
+// freed unused
+static void* volatile sink;
+
+template <typename T>
+static T* keep(T* ptr) {
+    sink = ptr;
+    return ptr;
+}
+
+int main() {
+    void* early = keep(malloc(32));
+    int* earlyArray = keep(new int[8]);
+    CHECK_EQ(MemoryMonitor::getLateAllocations(), 0);
+    MemoryMonitor::lockHeap();
+
+    uint32_t expected = 0;
+    void* block = keep(malloc(16));
+    expected++;
+    CHECK_EQ(MemoryMonitor::getLateAllocations(), expected);
+    block = keep(realloc(block, 64));     // String growing its buffer
+    expected++;
+    CHECK_EQ(MemoryMonitor::getLateAllocations(), expected);
+    void* zeroed = keep(calloc(4, 8));
+    expected++;
+    CHECK_EQ(MemoryMonitor::getLateAllocations(), expected);
+
+    int* one = keep(new int(1));
+    int* many = keep(new int[4]);
+    int* quiet = keep(new (std::nothrow) int);
+    int* quietMany = keep(new (std::nothrow) int[4]);
+    expected += 4;
+    CHECK_EQ(MemoryMonitor::getLateAllocations(), expected);
+
+    CacheLine* line = keep(new CacheLine);
+    CacheLine* lines = keep(new CacheLine[3]);
+    expected += 2;
+    CHECK_EQ(MemoryMonitor::getLateAllocations(), expected);
+    CHECK_EQ((uintptr_t)line % alignof(CacheLine), 0);
+    CHECK_EQ((uintptr_t)lines % alignof(CacheLine), 0);
+
+    // Freeing is not allocating
+    delete line;
+    delete[] lines;
+    delete one;
+    delete[] many;
+    delete quiet;
+    delete[] quietMany;
+    free(zeroed);
+    free(block);
+    free(early);
+    delete[] earlyArray;
+    CHECK_EQ(MemoryMonitor::getLateAllocations(), expected);
+
+    MemoryRegion regions[] = {{"test", 1}};
+    MemoryMonitor::printReport(Serial, regions, 1);
+
+    return checkResult("static_allocation");
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+// Plays a WAV file into A0 and runs the sketch's audio task on it, for
+// tuning the band edges and beat detection against real music. Prints the
+// features of every block, one line each:
+//
+//   <ms> <level> <beat 0/1> <band 0> ... <band 7>
+//
+//   nametag_audio <file.wav>
+
+#include <host.h>
+#include "audio_input.h"
+#include "audio_analyzer.h"
+#include "wav.h"
+
+static AudioInput audioInput;
+static AudioAnalyzer audioAnalyzer;
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <file.wav>\n", argv[0]);
+        return 2;
+    }
+    std::vector<int16_t> samples;
+    uint32_t rateHz;
+    if (!wav::read(argv[1], samples, rateHz)) {
+        fprintf(stderr, "%s: not a 16-bit PCM WAV file\n", argv[1]);
+        return 1;
+    }
+
+    host::useSimulatedTime(true);
+    host::setAnalogSignal(wav::toAdc(samples), rateHz);
+    unsigned long start = millis();
+    unsigned long lengthMs = (uint64_t)samples.size() * 1000 / rateHz;
+    uint32_t beats = 0;
+
+    // The audio task at every sample slot, analyzing each block it completes
+    audioInput.start();
+    int16_t block[AudioInput::BLOCK_SIZE];
+    while (millis() - start < lengthMs) {
+        host::advanceMicros(AudioInput::SAMPLE_PERIOD_US);
+        if (!audioInput.poll() || !audioInput.readBlock(block)) continue;
+        audioAnalyzer.process(block);
+        const AudioFeatures& features = audioAnalyzer.getFeatures();
+        if (features.beat) beats++;
+        printf("%lu %u %d", millis() - start, features.level, features.beat);
+        for (int b = 0; b < AudioFeatures::NUM_BANDS; b++) printf(" %u", features.bands[b]);
+        printf("\n");
+    }
+
+    fprintf(stderr, "%lu ms at %u Hz: %u beats\n", lengthMs, rateHz, beats);
+    return 0;
+}
\ No newline at end of file
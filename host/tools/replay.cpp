@@ -0,0 +1,81 @@
+// Replays a flight recorder dump off the device, for stepping through a
+// field stutter in a debugger. Takes a serial log holding 'd' output (the
+// lines from "REC" to "END"; anything around them is skipped) and prints
+// every strip refresh of the replay in the host/golden line format.
+//
+//   nametag_replay <serial log>
+
+#include <host.h>
+#include <string>
+#include <fstream>
+#include "state_manager.h"
+#include "output_manager.h"
+#include "remote_control.h"
+#include "recorder.h"
+
+static StateManager stateManager;
+static StateBuffer stateBuffer;
+static OutputManager outputManager;
+static PowerManager powerManager;
+static Schedule schedule;
+static RemoteControl remoteControl;
+static Recorder recorder;
+static Replayer replayer;
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <serial log>\n", argv[0]);
+        return 2;
+    }
+    std::ifstream in(argv[1]);
+    if (!in) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    recorder.begin(stateManager);
+    recorder.beginLoad();
+    std::string line;
+    bool inDump = false;
+    Recorder::LoadResult result = Recorder::LOAD_MORE;
+    while (result == Recorder::LOAD_MORE && std::getline(in, line)) {
+        if (!inDump) {
+            inDump = line.compare(0, 3, "REC") == 0;
+            continue;
+        }
+        result = recorder.loadLine(line.c_str());
+    }
+    if (result != Recorder::LOAD_DONE) {
+        fprintf(stderr, "%s: no complete dump found\n", argv[1]);
+        return 1;
+    }
+    fprintf(stderr, "loaded %u bytes\n", recorder.getSize());
+
+    host::useSimulatedTime(true);
+    stateManager.publish(stateBuffer);
+    outputManager.begin(stateBuffer);
+    remoteControl.begin(stateManager, outputManager, powerManager, recorder, schedule);
+    replayer.begin(recorder, stateManager,
+                   [](const ButtonEventData& event) { stateManager.handleButtonEvent(event); },
+                   [](uint8_t command, const uint8_t* payload, size_t length) {
+                       return remoteControl.applyCommand(command, payload, length);
+                   });
+    if (!replayer.start()) {
+        fprintf(stderr, "no keyframe in the dump\n");
+        return 1;
+    }
+
+    // Same pacing as the device: a state tick, then its strip refreshes
+    unsigned long refreshes = StateManager::UPDATE_INTERVAL_MS / outputManager.getRefreshInterval();
+    while (replayer.isRunning()) {
+        replayer.step(millis());
+        stateManager.publish(stateBuffer);
+        for (unsigned long r = 0; r < refreshes; r++) {
+            outputManager.update();
+            printf("%s\n", host::frameLine().c_str());
+            host::advanceMillis(outputManager.getRefreshInterval());
+        }
+    }
+    fprintf(stderr, "replayed %lu ticks\n", (unsigned long)replayer.getTickCount());
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#ifndef HOST_WAV_H
+#define HOST_WAV_H
+
+// Just enough WAV for the audio harness: 16-bit PCM, mono (other channels
+// are dropped on read)
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+namespace wav {
+
+static inline void put16(FILE* f, uint16_t v) {
+    uint8_t b[2] = {(uint8_t)v, (uint8_t)(v >> 8)};
+    fwrite(b, 1, 2, f);
+}
+
+static inline void put32(FILE* f, uint32_t v) {
+    put16(f, (uint16_t)v);
+    put16(f, (uint16_t)(v >> 16));
+}
+
+static inline uint32_t get(const uint8_t* b, int bytes) {
+    uint32_t v = 0;
+    for (int i = bytes - 1; i >= 0; i--) v = (v << 8) | b[i];
+    return v;
+}
+
+inline bool write(const char* path, const std::vector<int16_t>& samples, uint32_t rateHz) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    uint32_t dataBytes = samples.size() * 2;
+    fwrite("RIFF", 1, 4, f);
+    put32(f, 36 + dataBytes);
+    fwrite("WAVEfmt ", 1, 8, f);
+    put32(f, 16);
+    put16(f, 1);            // PCM
+    put16(f, 1);            // Mono
+    put32(f, rateHz);
+    put32(f, rateHz * 2);   // Bytes per second
+    put16(f, 2);            // Bytes per frame
+    put16(f, 16);
+    fwrite("data", 1, 4, f);
+    put32(f, dataBytes);
+    for (int16_t s : samples) put16(f, (uint16_t)s);
+    bool ok = !ferror(f);
+    return fclose(f) == 0 && ok;
+}
+
+inline bool read(const char* path, std::vector<int16_t>& samples, uint32_t& rateHz) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    std::vector<uint8_t> file;
+    uint8_t buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0) file.insert(file.end(), buffer, buffer + n);
+    fclose(f);
+    if (file.size() < 12 || memcmp(&file[0], "RIFF", 4) != 0 || memcmp(&file[8], "WAVE", 4) != 0) return false;
+
+    // Walk the chunks for fmt and data
+    uint16_t channels = 0;
+    bool haveFormat = false;
+    for (size_t pos = 12; pos + 8 <= file.size();) {
+        const uint8_t* chunk = &file[pos];
+        uint32_t size = get(chunk + 4, 4);
+        if (pos + 8 + size > file.size()) size = file.size() - pos - 8;
+        if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+            if (get(chunk + 8, 2) != 1 || get(chunk + 22, 2) != 16) return false;   // 16-bit PCM only
+            channels = get(chunk + 10, 2);
+            rateHz = get(chunk + 12, 4);
+            haveFormat = channels > 0 && rateHz > 0;
+        } else if (memcmp(chunk, "data", 4) == 0 && haveFormat) {
+            samples.clear();
+            for (uint32_t i = 0; i + 2 * channels <= size; i += 2 * channels) {
+                samples.push_back((int16_t)get(chunk + 8 + i, 2));
+            }
+            return true;
+        }
+        pos += 8 + size + (size & 1);
+    }
+    return false;
+}
+
+// To what the ESP8266 ADC reads off the mic board: 10 bits, biased to
+// mid-scale
+inline std::vector<int> toAdc(const std::vector<int16_t>& samples) {
+    std::vector<int> adc;
+    adc.reserve(samples.size());
+    for (int16_t s : samples) adc.push_back(512 + (s >> 6));
+    return adc;
+}
+
+}  // namespace wav
+
+#endif
\ No newline at end of file
@@ -0,0 +1,111 @@
+#include "audio_analyzer.h"
+
+// One full period of sin, Q15, FFT_SIZE entries
+const int16_t AudioAnalyzer::_sinTable[] PROGMEM = {
+    0,3212,6393,9512,12539,15446,18204,20787,23170,25329,27245,28898,30273,31356,32137,32609,
+    32767,32609,32137,31356,30273,28898,27245,25329,23170,20787,18204,15446,12539,9512,6393,3212,
+    0,-3212,-6393,-9512,-12539,-15446,-18204,-20787,-23170,-25329,-27245,-28898,-30273,-31356,-32137,-32609,
+    -32767,-32609,-32137,-31356,-30273,-28898,-27245,-25329,-23170,-20787,-18204,-15446,-12539,-9512,-6393,-3212
+};
+
+// First half of a symmetric Hann window, Q15
+const int16_t AudioAnalyzer::_hannTable[] PROGMEM = {
+    0,81,325,728,1286,1995,2847,3833,4944,6169,7495,8909,10398,11946,13539,15159,
+    16792,18421,20029,21601,23122,24575,25947,27224,28393,29443,30363,31145,31779,32260,32584,32747
+};
+
+// First FFT bin of each band (78 Hz per bin), roughly logarithmic
+const uint8_t AudioAnalyzer::_bandEdges[] PROGMEM = {
+    1, 2, 3, 5, 7, 11, 16, 23, 32
+};
+
+static inline int16_t readQ15(const int16_t* table, int index) {
+    return (int16_t)pgm_read_word(&table[index]);
+}
+
+void AudioAnalyzer::fft(int16_t* re, int16_t* im) {
+    const int n = FFT_SIZE;
+
+    // Bit-reverse reorder
+    for (int i = 1, j = 0; i < n; i++) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) {
+            int16_t t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+
+    for (int size = 2; size <= n; size <<= 1) {
+        int half = size >> 1;
+        int step = n / size;
+        for (int k = 0; k < half; k++) {
+            int16_t wr = readQ15(_sinTable, (k * step + n / 4) & (n - 1));  // cos
+            int16_t wi = -readQ15(_sinTable, k * step);                     // -sin
+            for (int i = k; i < n; i += size) {
+                int j = i + half;
+                int32_t tr = ((int32_t)wr * re[j] - (int32_t)wi * im[j]) >> 15;
+                int32_t ti = ((int32_t)wr * im[j] + (int32_t)wi * re[j]) >> 15;
+                re[j] = (re[i] - tr) >> 1;
+                im[j] = (im[i] - ti) >> 1;
+                re[i] = (re[i] + tr) >> 1;
+                im[i] = (im[i] + ti) >> 1;
+            }
+        }
+    }
+}
+
+// |z| without a square root: max + min/2 (within ~12%)
+static inline uint16_t magnitude(int16_t re, int16_t im) {
+    uint16_t a = abs(re);
+    uint16_t b = abs(im);
+    return a > b ? a + (b >> 1) : b + (a >> 1);
+}
+
+void AudioAnalyzer::process(const int16_t* block) {
+    unsigned long start = micros();
+
+    int16_t re[FFT_SIZE];
+    int16_t im[FFT_SIZE];
+    for (int i = 0; i < FFT_SIZE / 2; i++) {
+        int16_t w = readQ15(_hannTable, i);
+        re[i] = ((int32_t)block[i] * w) >> 15;
+        re[FFT_SIZE - 1 - i] = ((int32_t)block[FFT_SIZE - 1 - i] * w) >> 15;
+    }
+    memset(im, 0, sizeof(im));
+
+    fft(re, im);
+
+    // Band energies with per-band auto-gain: peaks jump up and decay slowly
+    uint32_t total = 0;
+    for (int b = 0; b < AudioFeatures::NUM_BANDS; b++) {
+        uint8_t first = pgm_read_byte(&_bandEdges[b]);
+        uint8_t last = pgm_read_byte(&_bandEdges[b + 1]);
+        uint32_t energy = 0;
+        for (int bin = first; bin < last; bin++) {
+            energy += magnitude(re[bin], im[bin]);
+        }
+        energy /= (last - first);
+        if (energy > 0xFFFF) energy = 0xFFFF;
+
+        if (energy > bandPeak[b]) bandPeak[b] = energy;
+        else bandPeak[b] -= bandPeak[b] >> 7;
+        uint16_t reference = bandPeak[b] < 64 ? 64 : bandPeak[b];  // Don't amplify silence
+
+        features.bands[b] = (energy * 255) / reference;
+        total += features.bands[b];
+    }
+    features.level = total / AudioFeatures::NUM_BANDS;
+
+    // Beat: bass well above its running average, with a refractory period
+    uint32_t bass = (uint32_t)features.bands[0] + features.bands[1];
+    unsigned long now = millis();
+    features.beat = (bass << 8) * 2 > bassAverage * 3 && bass > 96 &&
+                    now - lastBeat >= MIN_BEAT_INTERVAL_MS;
+    if (features.beat) lastBeat = now;
+    bassAverage += (int32_t)((bass << 8) - bassAverage) >> 4;
+
+    lastProcessUs = micros() - start;
+    if (lastProcessUs > maxProcessUs) maxProcessUs = lastProcessUs;
+}
\ No newline at end of file
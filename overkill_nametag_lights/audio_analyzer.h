@@ -0,0 +1,45 @@
+#ifndef AUDIO_ANALYZER_H
+#define AUDIO_ANALYZER_H
+
+#include <Arduino.h>
+#include "audio_input.h"
+
+// What the patterns get to see of the music
+struct AudioFeatures {
+    static const uint8_t NUM_BANDS = 8;
+    uint8_t bands[NUM_BANDS];   // Band energy, auto-gained to 0-255, low to high
+    uint8_t level;              // Overall loudness, 0-255
+    bool beat;                  // Bass onset in the latest block
+};
+
+// Fixed-point radix-2 FFT (no floats) plus band energies and beat detection
+class AudioAnalyzer {
+public:
+    static const uint16_t FFT_SIZE = AudioInput::BLOCK_SIZE;
+    static const uint16_t MIN_BEAT_INTERVAL_MS = 150;
+
+    // Process one block of Q15 samples, updating getFeatures()
+    void process(const int16_t* block);
+    const AudioFeatures& getFeatures() const { return features; }
+
+    // Per-block processing time, to check it fits alongside rendering
+    unsigned long getLastProcessUs() const { return lastProcessUs; }
+    unsigned long getMaxProcessUs() const { return maxProcessUs; }
+
+    // In-place Q15 FFT, each stage scaled by 1/2 so it cannot overflow
+    static void fft(int16_t* re, int16_t* im);
+
+private:
+    AudioFeatures features = {};
+    uint16_t bandPeak[AudioFeatures::NUM_BANDS] = {};   // Auto-gain reference per band
+    uint32_t bassAverage = 0;                           // 8 fractional bits
+    unsigned long lastBeat = 0;
+    unsigned long lastProcessUs = 0;
+    unsigned long maxProcessUs = 0;
+
+    static const int16_t _sinTable[] PROGMEM;
+    static const int16_t _hannTable[] PROGMEM;
+    static const uint8_t _bandEdges[] PROGMEM;
+};
+
+#endif
\ No newline at end of file
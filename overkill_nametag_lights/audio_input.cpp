@@ -0,0 +1,57 @@
+#include "audio_input.h"
+
+void AudioInput::start() {
+    running = true;
+    fill = 0;
+    ready = false;
+    nextSampleUs = micros();
+}
+
+void AudioInput::stop() {
+    running = false;
+}
+
+bool AudioInput::poll() {
+    if (!running) return false;
+
+    unsigned long now = micros();
+    long behind = (long)(now - nextSampleUs);
+    if (behind < -(long)(SAMPLE_PERIOD_US / 2)) return false;   // Nothing due yet
+    if (behind >= (long)BLOCK_TIME_US) {
+        // Starved for a whole block: start a fresh one rather than hold
+        fill = 0;
+        nextSampleUs = now;
+        behind = 0;
+    }
+
+    bool completed = false;
+    for (; behind >= (long)SAMPLE_PERIOD_US; behind -= SAMPLE_PERIOD_US) {
+        completed |= push(lastSample);
+        heldSamples++;
+    }
+
+    // Track the mic bias slowly (time constant ~256 samples)
+    int32_t sample = analogRead(A0);
+    dcLevel += ((sample << 8) - dcLevel) >> 8;
+    int32_t centered = (sample << 5) - (dcLevel >> 3);  // 10-bit ADC to Q15
+    lastSample = constrain(centered, -32768L, 32767L);
+    completed |= push(lastSample);
+    return completed;
+}
+
+bool AudioInput::push(int16_t sample) {
+    blocks[filling][fill++] = sample;
+    nextSampleUs += SAMPLE_PERIOD_US;
+    if (fill < BLOCK_SIZE) return false;
+    filling ^= 1;
+    fill = 0;
+    ready = true;
+    return true;
+}
+
+bool AudioInput::readBlock(int16_t* block) {
+    if (!ready) return false;
+    memcpy(block, blocks[filling ^ 1], sizeof(blocks[0]));
+    ready = false;
+    return true;
+}
\ No newline at end of file
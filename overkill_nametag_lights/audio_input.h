@@ -0,0 +1,47 @@
+#ifndef AUDIO_INPUT_H
+#define AUDIO_INPUT_H
+
+#include <Arduino.h>
+
+// Samples the microphone on A0, one sample per poll() from a scheduler task
+// run every SAMPLE_PERIOD_US. analogRead() goes through the SDK's SAR
+// driver, which is not safe to call from an interrupt, and pacing a whole
+// block in one run would stall every other task, so capture is spread over
+// many short runs. Sample slots that go by while another task has the CPU
+// repeat the previous sample. Blocks are double buffered: one fills while
+// the analyzer reads the other.
+class AudioInput {
+public:
+    static const uint32_t SAMPLE_RATE_HZ = 5000;
+    static const uint16_t BLOCK_SIZE = 64;      // One FFT
+    static const unsigned long SAMPLE_PERIOD_US = 1000000UL / SAMPLE_RATE_HZ;
+    static const unsigned long BLOCK_TIME_US = BLOCK_SIZE * SAMPLE_PERIOD_US;    // 12.8 ms
+
+    void start();
+    void stop();
+    bool isRunning() const { return running; }
+
+    // Take the sample that is due. Returns true when that completed a block.
+    bool poll();
+
+    // Copy out the latest complete block as signed Q15 samples with DC
+    // removed. Returns false when no block has completed since the last read.
+    bool readBlock(int16_t* block);
+
+    uint32_t getHeldSamples() const { return heldSamples; }  // Slots missed while another task ran
+
+private:
+    int16_t blocks[2][BLOCK_SIZE];
+    uint8_t filling = 0;            // Block poll() writes to, the other one is read
+    uint16_t fill = 0;
+    bool ready = false;
+    unsigned long nextSampleUs = 0;
+    int16_t lastSample = 0;
+    int32_t dcLevel = 512L << 8;    // Running mean of the ADC, 8 fractional bits
+    uint32_t heldSamples = 0;
+    bool running = false;
+
+    bool push(int16_t sample);
+};
+
+#endif
\ No newline at end of file
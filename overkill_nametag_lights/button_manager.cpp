@@ -1,26 +1,17 @@
 #include "button_manager.h"
 
+#ifndef USE_SHIFT_IN_BUTTONS
+
 void ButtonManager::begin() {
     for(int i = 0; i < NUM_BUTTONS; i++) {
         buttons[i].setUserId(i);
         
-        buttons[i].setClickHandler([&](EventButton& btn) {
-            this->onButtonClicked(btn);
-        });
-        
-        buttons[i].setDoubleClickHandler([&](EventButton& btn) {
-            this->onButtonDoubleClicked(btn);
-        });
-        
-        buttons[i].setLongPressHandler([&](EventButton& btn) {
-            this->onButtonLongPress(btn);
-        });
-
-        buttons[i].setReleasedHandler([&](EventButton& btn) {
-            this->onButtonReleased(btn);
-        });
+        buttons[i].setClickHandler(onButtonClicked);
+        buttons[i].setDoubleClickHandler(onButtonDoubleClicked);
+        buttons[i].setLongPressHandler(onButtonLongPress);
+        buttons[i].setReleasedHandler(onButtonReleased);
         
-        buttons[i].setLongClickDuration(500);
+        buttons[i].setLongClickDuration(LONG_CLICK_MS);
     }
 }
 
@@ -30,6 +21,14 @@ void ButtonManager::update() {
     }
 }
 
+const int* ButtonManager::getWakePins() const {
+    return BUTTON_PINS;
+}
+
+int ButtonManager::getWakePinCount() const {
+    return NUM_BUTTONS;
+}
+
 void ButtonManager::onButtonClicked(EventButton& btn) {
     ButtonEventData event{ButtonEvent::CLICKED, btn.userId()};
     EventBus::publish(event);
@@ -47,8 +46,127 @@ void ButtonManager::onButtonLongPress(EventButton& btn) {
 
 void ButtonManager::onButtonReleased(EventButton& btn) {
     // Only send release event if it was a long press
-    if (btn.previousDuration() > 500) {
+    if (btn.previousDuration() > LONG_CLICK_MS) {
         ButtonEventData event{ButtonEvent::LONG_PRESS_RELEASED, btn.userId()};
         EventBus::publish(event);
     }
-}
\ No newline at end of file
+}
+
+#else  // USE_SHIFT_IN_BUTTONS
+
+ButtonManager::ButtonManager() {
+    memset(raw, 0, sizeof(raw));
+    memset(stable, 0, sizeof(stable));
+    memset(longPressed, 0, sizeof(longPressed));
+    memset(tracking, 0, sizeof(tracking));
+    memset(rawChangedAt, 0, sizeof(rawChangedAt));
+    memset(edgeAt, 0, sizeof(edgeAt));
+    memset(clickCount, 0, sizeof(clickCount));
+}
+
+void ButtonManager::begin() {
+    pinMode(LOAD_PIN, OUTPUT);
+    pinMode(CLOCK_PIN, OUTPUT);
+    pinMode(DATA_PIN, INPUT);
+    digitalWrite(LOAD_PIN, HIGH);
+    digitalWrite(CLOCK_PIN, LOW);
+}
+
+void ButtonManager::scan(uint32_t* pressed) {
+    memset(pressed, 0, WORDS * sizeof(uint32_t));
+
+    // Latch all inputs, then clock them out. The first bit is already on
+    // the data pin before the first clock, so read before pulsing.
+    digitalWrite(LOAD_PIN, LOW);
+    delayMicroseconds(1);
+    digitalWrite(LOAD_PIN, HIGH);
+
+    for (int i = 0; i < NUM_REGISTERS * 8; i++) {
+        if (i < NUM_BUTTONS && digitalRead(DATA_PIN) == LOW) {
+            pressed[i >> 5] |= (1UL << (i & 31));
+        }
+        digitalWrite(CLOCK_PIN, HIGH);
+        digitalWrite(CLOCK_PIN, LOW);
+    }
+}
+
+void ButtonManager::update() {
+    uint32_t pressed[WORDS];
+    scan(pressed);
+    unsigned long now = millis();
+
+    for (int w = 0; w < WORDS; w++) {
+        // Only buttons that changed or are mid-gesture need any work
+        uint32_t work = (pressed[w] ^ raw[w]) | (raw[w] ^ stable[w]) | tracking[w];
+        while (work) {
+            int bit = __builtin_ctz(work);
+            work &= work - 1;
+            processButton(w * 32 + bit, (pressed[w] >> bit) & 1, now);
+        }
+    }
+}
+
+static inline bool testBit(const uint32_t* bits, int index) {
+    return (bits[index >> 5] >> (index & 31)) & 1;
+}
+
+static inline void writeBit(uint32_t* bits, int index, bool value) {
+    if (value) bits[index >> 5] |= (1UL << (index & 31));
+    else bits[index >> 5] &= ~(1UL << (index & 31));
+}
+
+// Same gestures as EventButton: click, double click, long press and the
+// release that ends a long press
+void ButtonManager::processButton(int index, bool rawPressed, unsigned long now) {
+    if (rawPressed != testBit(raw, index)) {
+        writeBit(raw, index, rawPressed);
+        rawChangedAt[index] = now;
+    }
+
+    bool isPressed = testBit(stable, index);
+    if (rawPressed != isPressed && now - rawChangedAt[index] >= DEBOUNCE_MS) {
+        isPressed = rawPressed;
+        writeBit(stable, index, isPressed);
+        edgeAt[index] = now;
+
+        if (!isPressed) {
+            if (testBit(longPressed, index)) {
+                writeBit(longPressed, index, false);
+                publish(ButtonEvent::LONG_PRESS_RELEASED, index);
+            } else if (++clickCount[index] >= 2) {
+                clickCount[index] = 0;
+                publish(ButtonEvent::DOUBLE_CLICKED, index);
+            }
+        }
+    }
+
+    if (isPressed && !testBit(longPressed, index) && now - edgeAt[index] >= LONG_CLICK_MS) {
+        writeBit(longPressed, index, true);
+        // Second press of a double click held down: the first was a click
+        if (clickCount[index] > 0) publish(ButtonEvent::CLICKED, index);
+        clickCount[index] = 0;
+        publish(ButtonEvent::LONG_PRESSED, index);
+    }
+
+    if (!isPressed && clickCount[index] > 0 && now - edgeAt[index] >= DOUBLE_CLICK_MS) {
+        clickCount[index] = 0;
+        publish(ButtonEvent::CLICKED, index);
+    }
+
+    writeBit(tracking, index, isPressed || clickCount[index] > 0 || rawPressed != isPressed);
+}
+
+void ButtonManager::publish(ButtonEvent type, int index) {
+    ButtonEventData event{type, index};
+    EventBus::publish(event);
+}
+
+const int* ButtonManager::getWakePins() const {
+    return nullptr;
+}
+
+int ButtonManager::getWakePinCount() const {
+    return 0;
+}
+
+#endif
\ No newline at end of file
@@ -2,11 +2,15 @@
 #define BUTTON_MANAGER_H
 
 #include <EventButton.h>
+#include "config.h"
 #include "events.h"
 
 class ButtonManager {
 public:
-    static const int NUM_BUTTONS = 6;
+    static const int NUM_BUTTONS = NAMETAG_NUM_OUTPUTS;
+    static const unsigned int LONG_CLICK_MS = 500;
+
+#ifndef USE_SHIFT_IN_BUTTONS
     const int BUTTON_PINS[NUM_BUTTONS] = {14, 12, 13, 5, 4, 0};
     
     // Initialize the buttons in the constructor initialization list
@@ -20,17 +24,50 @@ public:
             EventButton(BUTTON_PINS[5])
         } 
     {}
+#else
+    // 74HC165 chain, the first bit shifted out is button 0. Buttons pull low.
+    static const int LOAD_PIN = 13;
+    static const int CLOCK_PIN = 14;
+    static const int DATA_PIN = 12;
+    static const int NUM_REGISTERS = (NUM_BUTTONS + 7) / 8;
+    static const unsigned long DEBOUNCE_MS = 15;
+    static const unsigned long DOUBLE_CLICK_MS = 250;
+
+    ButtonManager();
+#endif
     
     void begin();
     void update();
 
+    // Pins that can wake the CPU on a press; none when scanning a chain
+    const int* getWakePins() const;
+    int getWakePinCount() const;
+
 private:
+#ifndef USE_SHIFT_IN_BUTTONS
     EventButton buttons[NUM_BUTTONS];
     
-    void onButtonClicked(EventButton& btn);
-    void onButtonDoubleClicked(EventButton& btn);
-    void onButtonLongPress(EventButton& btn);
-    void onButtonReleased(EventButton& btn);
+    // Static so they go to EventButton as plain functions, no captured state
+    static void onButtonClicked(EventButton& btn);
+    static void onButtonDoubleClicked(EventButton& btn);
+    static void onButtonLongPress(EventButton& btn);
+    static void onButtonReleased(EventButton& btn);
+#else
+    static const int WORDS = (NUM_BUTTONS + 31) / 32;
+
+    // Per-button flags as bitsets, so idle buttons cost one word test per 32
+    uint32_t raw[WORDS];            // Last scan
+    uint32_t stable[WORDS];         // Debounced
+    uint32_t longPressed[WORDS];    // Long press already reported
+    uint32_t tracking[WORDS];       // Gesture in progress, needs timing checks
+    unsigned long rawChangedAt[NUM_BUTTONS];
+    unsigned long edgeAt[NUM_BUTTONS];   // Last debounced press or release
+    uint8_t clickCount[NUM_BUTTONS];
+
+    void scan(uint32_t* pressed);
+    void processButton(int index, bool rawPressed, unsigned long now);
+    void publish(ButtonEvent type, int index);
+#endif
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include "compositor.h"
+
+Compositor::Compositor() {
+    for (int i = 0; i < NUM_LAYERS; i++) {
+        memset(layers[i].pixels, 0, sizeof(layers[i].pixels));
+        layers[i].mode = BlendMode::ALPHA;
+        layers[i].opacity = 0;
+        layers[i].fadeFrom = 0;
+        layers[i].fadeTarget = 0;
+        layers[i].fadeStart = 0;
+        layers[i].fadeDuration = 0;
+    }
+    memset(frame, 0, sizeof(frame));
+
+    layers[USER_LAYER].mode = BlendMode::REPLACE;
+    layers[USER_LAYER].opacity = 255;
+    layers[OVERLAY_LAYER].mode = BlendMode::ADD;
+}
+
+Rgb16Color* Compositor::getLayer(LayerId id) {
+    return layers[id].pixels;
+}
+
+void Compositor::setBlendMode(LayerId id, BlendMode mode) {
+    layers[id].mode = mode;
+}
+
+void Compositor::setOpacity(LayerId id, uint8_t opacity) {
+    layers[id].opacity = opacity;
+    layers[id].fadeDuration = 0;  // Cancel any running fade
+}
+
+uint8_t Compositor::getOpacity(LayerId id) const {
+    return layers[id].opacity;
+}
+
+bool Compositor::isVisible(LayerId id) const {
+    return layers[id].opacity > 0 || layers[id].fadeDuration > 0;
+}
+
+bool Compositor::isFading() const {
+    for (int i = 0; i < NUM_LAYERS; i++) {
+        if (layers[i].fadeDuration > 0) return true;
+    }
+    return false;
+}
+
+void Compositor::fadeTo(LayerId id, uint8_t opacity, uint16_t durationMs, unsigned long now) {
+    Layer& layer = layers[id];
+    if (durationMs == 0) {
+        setOpacity(id, opacity);
+        return;
+    }
+    layer.fadeFrom = layer.opacity;
+    layer.fadeTarget = opacity;
+    layer.fadeStart = now;
+    layer.fadeDuration = durationMs;
+}
+
+void Compositor::crossfade(uint16_t durationMs, unsigned long now) {
+    Layer& transition = layers[TRANSITION_LAYER];
+    memcpy(transition.pixels, frame, sizeof(frame));
+    transition.opacity = 255;
+    fadeTo(TRANSITION_LAYER, 0, durationMs, now);
+}
+
+void Compositor::compose(unsigned long now) {
+    memset(frame, 0, sizeof(frame));
+
+    for (int i = 0; i < NUM_LAYERS; i++) {
+        Layer& layer = layers[i];
+        updateFade(layer, now);
+        if (layer.opacity == 0) continue;  // Nothing to blend
+        blendLayer(frame, layer.pixels, layer.mode, layer.opacity);
+    }
+}
+
+const Rgb16Color& Compositor::getPixel(int index) const {
+    static const Rgb16Color black = {0, 0, 0};
+    if (index >= NUM_PIXELS) return black;
+    return frame[index];
+}
+
+void Compositor::updateFade(Layer& layer, unsigned long now) {
+    if (layer.fadeDuration == 0) return;
+
+    unsigned long elapsed = now - layer.fadeStart;
+    if (elapsed >= layer.fadeDuration) {
+        layer.opacity = layer.fadeTarget;
+        layer.fadeDuration = 0;
+        return;
+    }
+
+    // Fade progress as 0-256 fixed point
+    uint16_t progress = (elapsed << 8) / layer.fadeDuration;
+    int delta = (int)layer.fadeTarget - (int)layer.fadeFrom;
+    layer.opacity = layer.fadeFrom + ((delta * progress) >> 8);
+}
+
+// Scale a 16-bit channel by alpha (0-256)
+static inline uint16_t scale16(uint16_t value, uint16_t alpha) {
+    return ((uint32_t)value * alpha) >> 8;
+}
+
+// Mix b into a by alpha (0-256)
+static inline uint16_t lerp16(uint16_t a, uint16_t b, uint16_t alpha) {
+    return a + ((((int32_t)b - (int32_t)a) * (int32_t)alpha) >> 8);
+}
+
+static inline uint16_t qadd16(uint16_t a, uint16_t b) {
+    uint32_t sum = (uint32_t)a + b;
+    return sum > 0xFFFF ? 0xFFFF : sum;
+}
+
+void Compositor::blendLayer(Rgb16Color* dst, const Rgb16Color* src, BlendMode mode, uint8_t opacity) {
+    // Map 0-255 onto 0-256 so full opacity is an exact copy
+    uint16_t alpha = opacity + (opacity >> 7);
+
+    // Dispatch once per frame, not per pixel
+    switch (mode) {
+        case BlendMode::REPLACE:
+            for (int i = 0; i < NUM_PIXELS; i++) {
+                dst[i].R = scale16(src[i].R, alpha);
+                dst[i].G = scale16(src[i].G, alpha);
+                dst[i].B = scale16(src[i].B, alpha);
+            }
+            break;
+
+        case BlendMode::ADD:
+            for (int i = 0; i < NUM_PIXELS; i++) {
+                dst[i].R = qadd16(dst[i].R, scale16(src[i].R, alpha));
+                dst[i].G = qadd16(dst[i].G, scale16(src[i].G, alpha));
+                dst[i].B = qadd16(dst[i].B, scale16(src[i].B, alpha));
+            }
+            break;
+
+        case BlendMode::ALPHA:
+            for (int i = 0; i < NUM_PIXELS; i++) {
+                dst[i].R = lerp16(dst[i].R, src[i].R, alpha);
+                dst[i].G = lerp16(dst[i].G, src[i].G, alpha);
+                dst[i].B = lerp16(dst[i].B, src[i].B, alpha);
+            }
+            break;
+
+        case BlendMode::MAX:
+            for (int i = 0; i < NUM_PIXELS; i++) {
+                dst[i].R = max(dst[i].R, scale16(src[i].R, alpha));
+                dst[i].G = max(dst[i].G, scale16(src[i].G, alpha));
+                dst[i].B = max(dst[i].B, scale16(src[i].B, alpha));
+            }
+            break;
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef COMPOSITOR_H
+#define COMPOSITOR_H
+
+#include "led_control.h"
+
+// How a layer is combined with everything beneath it
+enum class BlendMode {
+    REPLACE,    // Layer (scaled by opacity) replaces what is below
+    ADD,        // Saturating add, good for notifications and highlights
+    ALPHA,      // Mix with what is below by the layer opacity
+    MAX         // Per-channel maximum
+};
+
+struct Layer {
+    Rgb16Color pixels[LEDController::NUM_LEDS];
+    BlendMode mode;
+    uint8_t opacity;
+
+    // Timed opacity fade, driven from compose()
+    uint8_t fadeFrom;
+    uint8_t fadeTarget;
+    unsigned long fadeStart;
+    uint16_t fadeDuration;      // 0 when no fade is running
+};
+
+// Combines the user, animation and overlay layers into the final frame.
+// Frames are 16 bits per channel; layer opacity is 8-bit fixed point and
+// blending runs over whole frames so the per-pixel cost stays a handful of
+// integer ops.
+class Compositor {
+public:
+    // Layers are composed bottom to top in this order
+    enum LayerId {
+        USER_LAYER,         // The user's own colors
+        ANIMATION_LAYER,    // Party mode patterns
+        OVERLAY_LAYER,      // StateManager::notify() flashes
+        TRANSITION_LAYER,   // Snapshot of the old frame during a crossfade
+        NUM_LAYERS
+    };
+
+    static const uint16_t NUM_PIXELS = LEDController::NUM_LEDS;
+
+    Compositor();
+
+    Rgb16Color* getLayer(LayerId id);
+    void setBlendMode(LayerId id, BlendMode mode);
+    void setOpacity(LayerId id, uint8_t opacity);
+    uint8_t getOpacity(LayerId id) const;
+    bool isVisible(LayerId id) const;
+    bool isFading() const;
+
+    // Fade a layer's opacity to the target over durationMs
+    void fadeTo(LayerId id, uint8_t opacity, uint16_t durationMs, unsigned long now);
+
+    // Freeze the current frame on top and fade it out, revealing whatever
+    // the layers below render next
+    void crossfade(uint16_t durationMs, unsigned long now);
+
+    void compose(unsigned long now);
+    const Rgb16Color& getPixel(int index) const;
+
+private:
+    Layer layers[NUM_LAYERS];
+    Rgb16Color frame[NUM_PIXELS];
+
+    static void updateFade(Layer& layer, unsigned long now);
+    static void blendLayer(Rgb16Color* dst, const Rgb16Color* src, BlendMode mode, uint8_t opacity);
+};
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+// Number of buttons, status LEDs and strip pixels. The nametag has 6; the
+// wall-panel variant builds with up to 64 (e.g. -DNAMETAG_NUM_OUTPUTS=32).
+#ifndef NAMETAG_NUM_OUTPUTS
+#define NAMETAG_NUM_OUTPUTS 6
+#endif
+
+#if NAMETAG_NUM_OUTPUTS < 1 || NAMETAG_NUM_OUTPUTS > 64
+#error "NAMETAG_NUM_OUTPUTS must be between 1 and 64"
+#endif
+
+// If defined, buttons are read from a chain of 74HC165 parallel-in shift
+// registers instead of one GPIO per button. Required for anything other
+// than the 6 direct button pins.
+#if NAMETAG_NUM_OUTPUTS != 6 && !defined(USE_SHIFT_IN_BUTTONS)
+#define USE_SHIFT_IN_BUTTONS
+#endif
+
+// If defined, the renderer may run on another thread than the state tick:
+// everything they share (triple_buffer.h) becomes std::atomic. The ESP8266
+// has one core, so only the host stress test (host/tests/render_thread.cpp)
+// builds this; a dual-core port would call OutputManager::update() from its
+// own task.
+// #define USE_RENDER_THREAD
+
+#if defined(USE_RENDER_THREAD) && defined(ESP8266)
+#error "USE_RENDER_THREAD needs a second core, the ESP8266 has one"
+#endif
+
+// If defined, heap allocations are counted once setup() is done; with
+// STATIC_ALLOCATION_TRAP as well, the first one panics with a stack dump.
+// Everything after setup() is meant to run from static memory, so a
+// non-zero count means something will slowly fragment the heap. malloc()
+// (Arduino String) is only seen when linking with
+//   -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc
+// e.g. arduino-cli --build-property "compiler.c.elf.extra_flags=<flags>".
+// #define STATIC_ALLOCATION_MODE
+// #define STATIC_ALLOCATION_TRAP
+
+#endif
@@ -0,0 +1,163 @@
+#include "diagnostics.h"
+#include "events.h"
+
+static volatile uint32_t benchSink;  // Keeps benchmarked results alive
+
+void Diagnostics::begin(StateManager& sm, OutputManager& om, Recorder& rec) {
+    stateManager = &sm;
+    outputManager = &om;
+    recorder = &rec;
+}
+
+void Diagnostics::checkPatterns(Print& out) {
+    for (uint8_t pattern = 0; pattern < StateManager::NUM_PATTERNS; pattern++) {
+        out.printf("CHECK pattern=%u ticks=%u checksum=%08lX\n", pattern, CHECK_TICKS,
+                   (unsigned long)patternChecksum(pattern));
+        yield();
+    }
+}
+
+uint32_t Diagnostics::patternChecksum(uint8_t pattern) {
+    StateManager sm;
+    startPattern(sm, pattern);
+
+    // FNV-1a over everything the patterns hand to the renderer
+    uint32_t hash = 2166136261UL;
+    for (uint16_t tick = 0; tick < CHECK_TICKS; tick++) {
+        feedAudio(sm, tick);
+        sm.update();
+        for (int i = 0; i < StateManager::MAX_OUTPUTS; i++) {
+            OutputState state = sm.getAnimationState(i);
+            uint8_t bytes[4] = {state.isOn, state.hue, (uint8_t)state.brightness, (uint8_t)(state.brightness >> 8)};
+            for (uint8_t b : bytes) {
+                hash = (hash ^ b) * 16777619UL;
+            }
+        }
+    }
+    return hash;
+}
+
+void Diagnostics::runBenchmarks(Print& out) {
+    unsigned long start = micros();
+    for (uint16_t i = 0; i < BENCH_ITERATIONS; i++) {
+        RgbColor color = LEDUtils::hsvToRgb(i, 255, 255);
+        benchSink += color.R;
+    }
+    report(out, "hsvToRgb", BENCH_ITERATIONS, micros() - start);
+
+    start = micros();
+    for (uint16_t i = 0; i < BENCH_ITERATIONS; i++) {
+        Rgb16Color color = LEDUtils::hsvToRgb16(i, 255, i * 65);
+        benchSink += color.R;
+    }
+    report(out, "hsvToRgb16", BENCH_ITERATIONS, micros() - start);
+
+    start = micros();
+    for (uint16_t i = 0; i < BENCH_ITERATIONS; i++) {
+        RgbColor color = LEDUtils::applyGamma(RgbColor(i, i >> 1, i >> 2));
+        benchSink += color.R;
+    }
+    report(out, "applyGamma", BENCH_ITERATIONS, micros() - start);
+
+    start = micros();
+    for (uint16_t i = 0; i < BENCH_ITERATIONS; i++) {
+        benchSink += LEDUtils::applyGamma16((uint16_t)(i * 65));
+    }
+    report(out, "applyGamma16", BENCH_ITERATIONS, micros() - start);
+    yield();
+
+    // What the patterns used to call per random byte, against what they call now
+    start = micros();
+    for (uint16_t i = 0; i < BENCH_ITERATIONS; i++) {
+        benchSink += random(256);
+    }
+    report(out, "random", BENCH_ITERATIONS, micros() - start);
+
+    Prng rng(CHECK_SEED);
+    start = micros();
+    for (uint16_t i = 0; i < BENCH_ITERATIONS; i++) {
+        benchSink += rng.next8();
+    }
+    report(out, "Prng::next8", BENCH_ITERATIONS, micros() - start);
+    yield();
+
+    // Real subscribers run, so pause recording and put the state back after.
+    // An even number of double clicks leaves the mode where it was.
+    StateSnapshot snapshot;
+    stateManager->saveSnapshot(snapshot);
+    bool recording = recorder->isEnabled();
+    recorder->setEnabled(false);
+    ButtonEventData event = {ButtonEvent::DOUBLE_CLICKED, 0};
+    start = micros();
+    for (uint16_t i = 0; i < BENCH_ITERATIONS; i++) {
+        EventBus::publish(event);
+    }
+    report(out, "EventBus::publish", BENCH_ITERATIONS, micros() - start);
+    stateManager->restoreSnapshot(snapshot);
+    recorder->setEnabled(recording);
+    yield();
+
+    ShiftRegisterController& shiftRegister = outputManager->getShiftRegister();
+    start = micros();
+    for (uint16_t i = 0; i < BENCH_ITERATIONS; i++) {
+        shiftRegister.updateAll();
+    }
+    report(out, "ShiftRegisterController::updateAll", BENCH_ITERATIONS, micros() - start);
+    yield();
+
+    // A whole strip refresh (compose, dither, push), which FAST mode pays
+    // STANDARD_REFRESH_MS / FAST_REFRESH_MS times per state tick
+    start = micros();
+    for (uint16_t i = 0; i < BENCH_ITERATIONS; i++) {
+        outputManager->update();
+    }
+    report(out, "OutputManager::update", BENCH_ITERATIONS, micros() - start);
+    yield();
+
+    LEDController& leds = outputManager->getLEDController();
+    start = micros();
+    for (uint16_t i = 0; i < BENCH_ITERATIONS; i++) {
+        leds.show();
+    }
+    report(out, "LEDController::show", BENCH_ITERATIONS, micros() - start);
+    yield();
+
+    // Patterns time a whole state tick, audio feed excluded
+    for (uint8_t pattern = 0; pattern < StateManager::NUM_PATTERNS; pattern++) {
+        StateManager sm;
+        startPattern(sm, pattern);
+        unsigned long elapsed = 0;
+        for (uint16_t tick = 0; tick < CHECK_TICKS; tick++) {
+            feedAudio(sm, tick);
+            start = micros();
+            sm.update();
+            elapsed += micros() - start;
+        }
+        char name[16];
+        snprintf(name, sizeof(name), "pattern%u", pattern);
+        report(out, name, CHECK_TICKS, elapsed);
+        yield();
+    }
+}
+
+void Diagnostics::startPattern(StateManager& sm, uint8_t pattern) {
+    sm.setRandomSeed(CHECK_SEED);
+    sm.toggleAnimationMode();
+    if (pattern >= StateManager::NUM_BASE_PATTERNS) sm.toggleSoundReactive();
+    sm.setAnimationPattern(pattern);
+}
+
+void Diagnostics::feedAudio(StateManager& sm, uint16_t tick) {
+    // Made-up but repeatable music, with a beat every half second
+    Prng rng(Prng::seedForFrame(CHECK_SEED, tick));
+    AudioFeatures features;
+    rng.fill(features.bands, AudioFeatures::NUM_BANDS);
+    features.level = rng.next8();
+    features.beat = tick % 25 == 0;
+    sm.setAudioFeatures(features);
+}
+
+void Diagnostics::report(Print& out, const char* name, uint16_t iterations, unsigned long elapsedUs) {
+    out.printf("BENCH name=%s iterations=%u total_us=%lu ns_per_op=%lu\n", name, iterations, elapsedUs,
+               elapsedUs * 1000UL / iterations);
+}
\ No newline at end of file
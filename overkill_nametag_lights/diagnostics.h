@@ -0,0 +1,49 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <Arduino.h>
+#include "state_manager.h"
+#include "output_manager.h"
+#include "recorder.h"
+
+/*
+On-device self checks and kernel timings, printed one result per line so a
+serial log can be diffed between firmware builds:
+
+  CHECK pattern=<n> ticks=<n> checksum=<hex>
+  BENCH name=<kernel> iterations=<n> total_us=<n> ns_per_op=<n>
+
+Pattern checks render every pattern from a fixed seed and synthetic audio on
+a scratch StateManager, so the live state is left alone. The float math in
+the patterns follows the toolchain's libm, so checksums are only compared
+between device builds; the host test suite (host/) keeps golden frames of
+the composited, dithered strip output for the same scenarios.
+*/
+
+class Diagnostics {
+public:
+    static const uint32_t CHECK_SEED = 0x5EED1234;
+    static const uint16_t CHECK_TICKS = 250;        // 5 s of each pattern
+    static const uint16_t BENCH_ITERATIONS = 1000;
+
+    void begin(StateManager& stateManager, OutputManager& outputManager, Recorder& recorder);
+
+    void checkPatterns(Print& out);
+    void runBenchmarks(Print& out);
+
+    // Checksum of CHECK_TICKS frames of one pattern's output
+    static uint32_t patternChecksum(uint8_t pattern);
+
+    // The fixed scenario behind the checks, shared with the host tests
+    static void startPattern(StateManager& sm, uint8_t pattern);
+    static void feedAudio(StateManager& sm, uint16_t tick);
+
+private:
+    StateManager* stateManager = nullptr;
+    OutputManager* outputManager = nullptr;
+    Recorder* recorder = nullptr;
+
+    static void report(Print& out, const char* name, uint16_t iterations, unsigned long elapsedUs);
+};
+
+#endif
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "events.h"
 
-// Initialize the static vector
-std::vector<EventHandler> EventBus::handlers;
\ No newline at end of file
+// Initialize the handler table
+EventHandler EventBus::handlers[EventBus::MAX_HANDLERS];
+int EventBus::handlerCount = 0;
\ No newline at end of file
@@ -1,9 +1,6 @@
 #ifndef EVENTS_H
 #define EVENTS_H
 
-#include <vector>
-#include <functional>
-
 // Define event types
 enum class ButtonEvent {
     CLICKED,
@@ -18,24 +15,30 @@ struct ButtonEventData {
     int buttonIndex;
 };
 
-// Event handler function type
-using EventHandler = std::function<void(const ButtonEventData&)>;
+// Event handler function type. Plain function pointers in a fixed table, so
+// subscribing and publishing never touch the heap.
+using EventHandler = void (*)(const ButtonEventData&);
 
 // Event bus
 class EventBus {
 public:
-    static void subscribe(EventHandler handler) {
-        handlers.push_back(handler);
+    static const int MAX_HANDLERS = 4;
+
+    static bool subscribe(EventHandler handler) {
+        if (handlerCount >= MAX_HANDLERS) return false;
+        handlers[handlerCount++] = handler;
+        return true;
     }
     
     static void publish(const ButtonEventData& event) {
-        for(auto& handler : handlers) {
-            handler(event);
+        for (int i = 0; i < handlerCount; i++) {
+            handlers[i](event);
         }
     }
 
 private:
-    static std::vector<EventHandler> handlers;
+    static EventHandler handlers[MAX_HANDLERS];
+    static int handlerCount;
 };
 
 #endif
\ No newline at end of file
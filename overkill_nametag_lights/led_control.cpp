@@ -20,13 +20,45 @@ const uint8_t LEDUtils::_sin8Table[] PROGMEM = {
     79,82,85,88,90,93,97,100,103,106,109,112,115,118,121,124
 };
 
+Prng LEDUtils::_rng;
+
+#ifdef USE_GAMMA_TABLE
+// Gamma 1/0.45 (same curve as NeoGammaEquationMethod) at 16-bit resolution
+const uint16_t LEDUtils::_gamma16Table[] PROGMEM = {
+    0,0,1,3,6,10,16,22,30,38,49,60,73,87,103,120,
+    138,158,180,203,227,253,281,310,340,373,407,442,479,518,559,601,
+    645,691,738,787,838,891,945,1001,1059,1119,1180,1244,1309,1376,1445,1516,
+    1588,1663,1739,1817,1897,1979,2063,2149,2237,2327,2419,2512,2608,2705,2805,2906,
+    3010,3115,3223,3333,3444,3558,3673,3791,3911,4032,4156,4282,4410,4540,4672,4806,
+    4942,5081,5221,5363,5508,5655,5804,5955,6108,6263,6421,6580,6742,6906,7072,7241,
+    7411,7584,7758,7935,8115,8296,8480,8666,8854,9044,9237,9431,9628,9828,10029,10233,
+    10439,10647,10857,11070,11285,11503,11722,11944,12168,12395,12624,12855,13088,13324,13562,13802,
+    14045,14290,14537,14787,15039,15293,15550,15809,16070,16334,16600,16869,17140,17413,17689,17967,
+    18247,18530,18815,19102,19392,19685,19980,20277,20576,20878,21183,21490,21799,22111,22425,22742,
+    23061,23382,23706,24033,24362,24693,25027,25363,25702,26043,26387,26733,27081,27432,27786,28142,
+    28501,28862,29226,29592,29960,30331,30705,31081,31460,31841,32225,32611,33000,33391,33785,34182,
+    34581,34982,35386,35793,36202,36614,37028,37445,37864,38286,38711,39138,39568,40000,40435,40872,
+    41312,41755,42200,42648,43099,43552,44007,44466,44927,45390,45856,46325,46796,47270,47747,48226,
+    48708,49193,49680,50170,50662,51157,51655,52155,52659,53164,53673,54184,54697,55214,55733,56255,
+    56779,57306,57836,58368,58903,59441,59982,60525,61071,61619,62171,62724,63281,63841,64403,64967,
+    65535
+};
+#endif
+
 LEDController::LEDController() : 
     strip(NUM_LEDS, LED_PIN)
 {
     memset(ledHues, 0, sizeof(ledHues));
     memset(ledBrightness, 255, sizeof(ledBrightness));
     memset(ledActive, 0, sizeof(ledActive));
-    randomSeed(analogRead(0)); // Initialize random number generator
+    memset(frame, 0, sizeof(frame));
+    memset(ditherError, 0, sizeof(ditherError));
+    frameLevel = 0;
+    powerBudget = DEFAULT_POWER_BUDGET_MA;
+    estimatedCurrent = 0;
+    powerScale = 0x10000;
+    masterBrightness = 255;
+    LEDUtils::randomSeed8(analogRead(0)); // Initialize random number generator
 }
 
 void LEDController::begin() {
@@ -34,7 +66,7 @@ void LEDController::begin() {
     strip.Show(); // Clear all pixels
 }
 
-void LEDController::updateLED(int index, bool isOn, uint8_t hue, uint8_t brightness) {
+void LEDController::updateLED(int index, bool isOn, uint8_t hue, uint16_t brightness) {
     if (index >= NUM_LEDS) return;
     
     ledActive[index] = isOn;
@@ -42,19 +74,82 @@ void LEDController::updateLED(int index, bool isOn, uint8_t hue, uint8_t brightn
     ledBrightness[index] = brightness;
     
     if (isOn) {
-        RgbColor color = hsvToRgb(hue, 255, brightness);
-        color = LEDUtils::applyGamma(color);
-        strip.SetPixelColor(index, color);
+        setPixel(index, LEDUtils::hsvToRgb16(hue, 255, brightness));
     } else {
-        strip.SetPixelColor(index, RgbColor(0));
+        setPixel(index, {0, 0, 0});
+    }
+}
+
+void LEDController::setPixel(int index, const Rgb16Color& color) {
+    if (index >= NUM_LEDS) return;
+    // Keep the running channel total current as pixels change, so the
+    // estimate costs nothing extra at show()
+    frameLevel -= (uint32_t)frame[index].R + frame[index].G + frame[index].B;
+    frame[index] = LEDUtils::applyGamma16(color);
+    frameLevel += (uint32_t)frame[index].R + frame[index].G + frame[index].B;
+}
+
+void LEDController::setPowerBudget(uint16_t milliamps) {
+    powerBudget = milliamps;
+}
+
+void LEDController::updatePowerLimit() {
+    // Channel level is linear in current once gamma has been applied.
+    // Estimate the dimmed frame so dimming leaves more of the budget.
+    uint32_t channelCurrent = ((frameLevel >> 8) * MILLIAMPS_PER_CHANNEL) >> 8;
+    channelCurrent = (channelCurrent * masterScale()) >> 8;
+    uint32_t idleCurrent = (uint32_t)NUM_LEDS * MILLIAMPS_IDLE_PER_LED;
+    estimatedCurrent = channelCurrent + idleCurrent;
+
+    if (powerBudget == 0 || estimatedCurrent <= powerBudget || channelCurrent == 0) {
+        powerScale = 0x10000;
+        return;
     }
+
+    // Leave room for the LEDs' idle draw, which does not scale
+    uint32_t available = powerBudget > idleCurrent ? powerBudget - idleCurrent : 0;
+    powerScale = (available << 16) / channelCurrent;
+}
+
+// Reduce one 16-bit channel to 8 bits, carrying the remainder into the next refresh,
+// after applying the power limit scale (16.16 fixed point)
+static inline uint8_t reduceChannel(uint16_t channel, uint32_t scale, uint8_t& error) {
+    uint32_t value = ((uint32_t)channel * scale) >> 16;
+#ifdef USE_TEMPORAL_DITHER
+    uint32_t sum = value + error;
+    if (sum > 0xFFFF) {
+        error = 0;
+        return 255;
+    }
+    error = sum & 0xFF;
+    return sum >> 8;
+#else
+    (void)error;
+    return value > 0xFF7F ? 255 : (value + 0x80) >> 8;
+#endif
 }
 
 void LEDController::show() {
+    updatePowerLimit();
+    uint32_t scale = (powerScale * masterScale()) >> 8;
+
+    // Dimming, power scaling and 8-bit reduction in a single pass
+    for (int i = 0; i < NUM_LEDS; i++) {
+        uint8_t r = reduceChannel(frame[i].R, scale, ditherError[i][0]);
+        uint8_t g = reduceChannel(frame[i].G, scale, ditherError[i][1]);
+        uint8_t b = reduceChannel(frame[i].B, scale, ditherError[i][2]);
+        strip.SetPixelColor(i, RgbColor(r, g, b));
+    }
     strip.Show();
 }
 
-RgbColor LEDController::hsvToRgb(uint8_t h, uint8_t s, uint8_t v) {
+void LEDController::showRounded() {
+    // Half a step of carried error makes the dithered reduction round
+    memset(ditherError, 0x80, sizeof(ditherError));
+    show();
+}
+
+RgbColor LEDUtils::hsvToRgb(uint8_t h, uint8_t s, uint8_t v) {
     uint8_t r, g, b;
     
     uint8_t region = h / 43;
@@ -74,4 +169,26 @@ RgbColor LEDController::hsvToRgb(uint8_t h, uint8_t s, uint8_t v) {
     }
     
     return RgbColor(r, g, b);
+}
+
+Rgb16Color LEDUtils::hsvToRgb16(uint8_t h, uint8_t s, uint16_t v) {
+    uint16_t r, g, b;
+
+    uint8_t region = h / 43;
+    uint8_t remainder = (h - (region * 43)) * 6;
+
+    uint16_t p = ((uint32_t)v * (255 - s)) >> 8;
+    uint16_t q = ((uint32_t)v * (255 - ((s * remainder) >> 8))) >> 8;
+    uint16_t t = ((uint32_t)v * (255 - ((s * (255 - remainder)) >> 8))) >> 8;
+
+    switch (region) {
+        case 0:  r = v; g = t; b = p; break;
+        case 1:  r = q; g = v; b = p; break;
+        case 2:  r = p; g = v; b = t; break;
+        case 3:  r = p; g = q; b = v; break;
+        case 4:  r = t; g = p; b = v; break;
+        default: r = v; g = p; b = q; break;
+    }
+
+    return {r, g, b};
 }
\ No newline at end of file
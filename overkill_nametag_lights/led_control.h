@@ -2,11 +2,25 @@
 #define LEDCONTROL_H
 
 #include <NeoPixelBus.h>
+#include "config.h"
+#include "prng.h"
 
 // If defined, use the table-based gamma correction, using more memory but is faster
 // If not defined, use the equation based correction. Slower but smaller.
 #define USE_GAMMA_TABLE 
 
+// If defined, the 16-bit frame is reduced to 8 bits with temporal dithering
+// (per-pixel error carried between refreshes) so low-brightness fades stay smooth.
+// If not defined, the frame is simply rounded to 8 bits.
+#define USE_TEMPORAL_DITHER
+
+// Internal 16-bit-per-channel color, used from pattern output through gamma
+struct Rgb16Color {
+    uint16_t R;
+    uint16_t G;
+    uint16_t B;
+};
+
 // Utility class to replace FastLED math functions
 class LEDUtils {
 public:
@@ -15,15 +29,19 @@ public:
     }
     
     static uint8_t random8() {
-        return random(256);
+        return _rng.next8();
     }
     
     static uint8_t random8(uint8_t max) {
-        return random(max);
+        return _rng.next8(max);
     }
     
     static uint8_t random8(uint8_t min, uint8_t max) {
-        return random(min, max);
+        return _rng.next8(min, max);
+    }
+
+    static void randomSeed8(uint32_t seed) {
+        _rng.setSeed(seed);
     }
     
     static uint8_t scale8(uint8_t i, uint8_t scale) {
@@ -39,30 +57,84 @@ public:
         return colorGamma.Correct(color);
     }
 
+    static uint16_t applyGamma16(uint16_t value) {
+#ifdef USE_GAMMA_TABLE
+        // Interpolate between table entries on the low byte
+        uint8_t index = value >> 8;
+        uint16_t lo = pgm_read_word(&_gamma16Table[index]);
+        uint16_t hi = pgm_read_word(&_gamma16Table[index + 1]);
+        return lo + (((uint32_t)(hi - lo) * (value & 0xFF)) >> 8);
+#else
+        return (uint16_t)(pow(value / 65535.0f, 1.0f / 0.45f) * 65535.0f + 0.5f);
+#endif
+    }
+
+    static Rgb16Color applyGamma16(const Rgb16Color& color) {
+        return {applyGamma16(color.R), applyGamma16(color.G), applyGamma16(color.B)};
+    }
+
+    static RgbColor hsvToRgb(uint8_t h, uint8_t s, uint8_t v);
+    static Rgb16Color hsvToRgb16(uint8_t h, uint8_t s, uint16_t v);
+
 private:
     // Pre-calculated sine table
     static const uint8_t _sin8Table[] PROGMEM;
+    static Prng _rng;
+#ifdef USE_GAMMA_TABLE
+    // 16-bit gamma curve sampled every 256 input steps, 257 entries for interpolation
+    static const uint16_t _gamma16Table[] PROGMEM;
+#endif
 };
 
 class LEDController {
 public:
-    static const uint16_t NUM_LEDS = 6;
+    static const uint16_t NUM_LEDS = NAMETAG_NUM_OUTPUTS;
     static const uint8_t LED_PIN = 2;
     static const uint8_t BRIGHTNESS = 128;
 
+    // Current estimate for WS2811/WS2812 pixels
+    static const uint16_t MILLIAMPS_PER_CHANNEL = 20;    // One channel at full duty
+    static const uint16_t MILLIAMPS_IDLE_PER_LED = 1;    // Driver quiescent draw
+    static const uint16_t DEFAULT_POWER_BUDGET_MA = 400; // USB power bank minus the ESP itself
+
     LEDController();
     void begin();
-    void updateLED(int index, bool isOn, uint8_t hue, uint8_t brightness);
-    void show();
+    void updateLED(int index, bool isOn, uint8_t hue, uint16_t brightness);
+    void setPixel(int index, const Rgb16Color& color);  // Composited color, gamma applied here
+    void show();  // Reduce the 16-bit frame to 8 bits and push it to the strip
+    void showRounded();  // Same, rounded instead of dithered, for a frame that stays up
+
+    // Frame-level power limiting. A budget of 0 disables the limiter.
+    void setPowerBudget(uint16_t milliamps);
+    uint16_t getPowerBudget() const { return powerBudget; }
+    uint32_t getEstimatedCurrent() const { return estimatedCurrent; }  // Unlimited frame, mA
+    uint16_t getPowerLimitPercent() const { return (powerScale * 100) >> 16; }
+    bool isPowerLimited() const { return powerScale < 0x10000; }
+
+    // Overall dimming (schedule brightness curves, blackout), 255 = full.
+    // Applied in the same pass as the power limit.
+    void setMasterBrightness(uint8_t level) { masterBrightness = level; }
+    uint8_t getMasterBrightness() const { return masterBrightness; }
 
 private:
     // Using NeoPixelBus with Neo800KbpsMethod for WS2811
     NeoPixelBus<NeoGrbFeature, NeoEsp8266Uart1Ws2812xMethod> strip;
     uint8_t ledHues[NUM_LEDS];
-    uint8_t ledBrightness[NUM_LEDS];
+    uint16_t ledBrightness[NUM_LEDS];
     bool ledActive[NUM_LEDS];
-    
-    RgbColor hsvToRgb(uint8_t h, uint8_t s, uint8_t v);
+    Rgb16Color frame[NUM_LEDS];           // Gamma-corrected 16-bit frame
+    uint8_t ditherError[NUM_LEDS][3];     // Carried low byte per channel
+
+    uint32_t frameLevel;        // Sum of all gamma-corrected channels in frame
+    uint16_t powerBudget;       // mA, 0 for unlimited
+    uint32_t estimatedCurrent;  // mA before limiting
+    uint32_t powerScale;        // 16.16 fixed point, 0x10000 when not limiting
+    uint8_t masterBrightness;
+
+    void updatePowerLimit();
+
+    // Map 0-255 onto 0-256 so full brightness is exact and 0 is dark
+    uint16_t masterScale() const { return masterBrightness + (masterBrightness >> 7); }
 };
 
 #endif
\ No newline at end of file
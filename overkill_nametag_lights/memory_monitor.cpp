@@ -0,0 +1,144 @@
+#include "memory_monitor.h"
+#include <stdlib.h>
+#include <new>
+
+bool MemoryMonitor::heapLocked = false;
+uint32_t MemoryMonitor::minFreeHeap = 0xFFFFFFFF;
+uint32_t MemoryMonitor::lateAllocations = 0;
+uint32_t MemoryMonitor::lateAllocationBytes = 0;
+
+void MemoryMonitor::lockHeap() {
+    heapLocked = true;
+    minFreeHeap = ESP.getFreeHeap();
+}
+
+void MemoryMonitor::update() {
+    uint32_t freeHeap = ESP.getFreeHeap();
+    if (freeHeap < minFreeHeap) minFreeHeap = freeHeap;
+}
+
+void MemoryMonitor::printReport(Print& out, const MemoryRegion* regions, size_t count) {
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        out.printf("MEM static name=%s bytes=%u\n", regions[i].name, (unsigned)regions[i].bytes);
+        total += regions[i].bytes;
+    }
+    out.printf("MEM static name=total bytes=%u\n", (unsigned)total);
+
+    update();
+    out.printf("MEM heap free=%u min_free=%u max_block=%u fragmentation=%u\n", ESP.getFreeHeap(),
+               minFreeHeap, ESP.getMaxFreeBlockSize(), ESP.getHeapFragmentation());
+    out.printf("MEM stack free=%u\n", ESP.getFreeContStack());  // Low-water mark since boot
+    out.printf("MEM allocations after_setup=%lu bytes=%lu\n", (unsigned long)lateAllocations,
+               (unsigned long)lateAllocationBytes);
+}
+
+void MemoryMonitor::noteAllocation(size_t bytes) {
+    if (!heapLocked) return;
+    lateAllocations++;
+    lateAllocationBytes += bytes;
+#ifdef STATIC_ALLOCATION_TRAP
+    panic();
+#endif
+}
+
+#ifdef STATIC_ALLOCATION_MODE
+// Counts every allocation made through malloc(). The core defines malloc()
+// itself, so Arduino String and the rest of the core only reach these
+// wrappers when the build links with
+//   -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc
+// (see config.h). lwIP takes its packet buffers from malloc() as well, so
+// remote replies and frame streaming show up in the count too.
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size) {
+    MemoryMonitor::noteAllocation(size);
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    MemoryMonitor::noteAllocation(count * size);
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    if (size > 0) MemoryMonitor::noteAllocation(size);     // 0 frees
+    return __real_realloc(ptr, size);
+}
+}
+
+// Every form of operator new goes through malloc() and so past the count.
+// Over-aligned types get a larger block, with malloc()'s pointer stored just
+// below the aligned one for delete.
+static void* alignedAlloc(size_t size, std::align_val_t alignment) {
+    size_t align = (size_t)alignment;
+    uint8_t* raw = (uint8_t*)malloc(size + align + sizeof(void*));
+    if (!raw) return nullptr;
+    uintptr_t aligned = ((uintptr_t)raw + sizeof(void*) + align - 1) & ~(uintptr_t)(align - 1);
+    ((void**)aligned)[-1] = raw;
+    return (void*)aligned;
+}
+
+static void alignedFree(void* ptr) {
+    if (ptr) free(((void**)ptr)[-1]);
+}
+
+void* operator new(size_t size) {
+    return malloc(size);
+}
+
+void* operator new[](size_t size) {
+    return malloc(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return malloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return malloc(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    return alignedAlloc(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+    return alignedAlloc(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    alignedFree(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+    alignedFree(ptr);
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept {
+    alignedFree(ptr);
+}
+
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept {
+    alignedFree(ptr);
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef MEMORY_MONITOR_H
+#define MEMORY_MONITOR_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// One line of the static RAM report
+struct MemoryRegion {
+    const char* name;
+    size_t bytes;
+};
+
+// Heap and stack watermarks for long uptimes. Report lines:
+//
+//   MEM static name=<subsystem> bytes=<n>
+//   MEM heap free=<n> min_free=<n> max_block=<n> fragmentation=<pct>
+//   MEM stack free=<n>
+//   MEM allocations after_setup=<n> bytes=<n>
+class MemoryMonitor {
+public:
+    // Call last in setup(): the heap should not move after this
+    static void lockHeap();
+    static bool isHeapLocked() { return heapLocked; }
+
+    // Sample the free heap, call once per loop
+    static void update();
+
+    static void printReport(Print& out, const MemoryRegion* regions, size_t count);
+
+    // Called by the allocation hook in STATIC_ALLOCATION_MODE
+    static void noteAllocation(size_t bytes);
+    static uint32_t getLateAllocations() { return lateAllocations; }
+
+private:
+    static bool heapLocked;
+    static uint32_t minFreeHeap;
+    static uint32_t lateAllocations;
+    static uint32_t lateAllocationBytes;
+};
+
+#endif
\ No newline at end of file
@@ -1,24 +1,110 @@
 #include "output_manager.h"
-#include "button_manager.h"
 
-void OutputManager::begin(StateManager& sm) {
-    stateManager = &sm;
+void OutputManager::begin(StateBuffer& buffer) {
+    states = &buffer;
     ledController.begin();
     shiftRegister.begin();
+
+    const StateSnapshot& state = states->read();
+    lastAnimating = state.animState.isAnimating;
+    lastPattern = state.animState.pattern;
+    lastNotifyCount = state.animState.notifyCount;
+    compositor.setOpacity(Compositor::ANIMATION_LAYER, lastAnimating ? 255 : 0);
 }
 
 void OutputManager::update() {
-    for (int i = 0; i < ButtonManager::NUM_BUTTONS; i++) {
-        const OutputState& state = stateManager->getState(i);
-        if (stateManager->isInAnimationMode()) {
-            ledController.updateLED(i, state.isOn, state.hue, state.brightness);
-            shiftRegister.updateRegister(i + 1, (i == stateManager->getAnimationPattern()));
+    unsigned long now = millis();
+    const StateSnapshot& state = states->read();
+    checkTransitions(state, now);
+    ledController.setMasterBrightness(state.masterBrightness);
+
+    Rgb16Color* userLayer = compositor.getLayer(Compositor::USER_LAYER);
+    Rgb16Color* animLayer = compositor.getLayer(Compositor::ANIMATION_LAYER);
+    bool renderAnimation = compositor.isVisible(Compositor::ANIMATION_LAYER);
+    bool statusLeds = ledController.getMasterBrightness() > 0;  // Dark means all of it
+
+    for (int i = 0; i < StateManager::MAX_OUTPUTS; i++) {
+        userLayer[i] = renderState(state.outputs.get(i));
+        if (renderAnimation) {
+            animLayer[i] = renderState(state.animOutputs.get(i));
+        }
+
+        if (state.animState.isAnimating) {
+            // Sound patterns share buttons with the regular ones
+            uint8_t patternButton = state.animState.pattern % StateManager::NUM_BASE_PATTERNS;
+            shiftRegister.updateRegister(i + 1, statusLeds && (i == patternButton));
         } else {
-            ledController.updateLED(i, state.isOn, state.hue, state.brightness);
-            shiftRegister.updateRegister(i + 1, state.isOn);
+            shiftRegister.updateRegister(i + 1, statusLeds && OutputBank::getBit(state.outputs.on, i));
+        }
+    }
+
+    compositor.compose(now);
+    bool changed = false;
+    for (int i = 0; i < LEDController::NUM_LEDS; i++) {
+        const Rgb16Color& pixel = compositor.getPixel(i);
+        if (pixel.R != lastFrame[i].R || pixel.G != lastFrame[i].G || pixel.B != lastFrame[i].B) {
+            lastFrame[i] = pixel;
+            changed = true;
         }
+        ledController.setPixel(i, pixel);
+    }
+    if (changed) {
+        memcpy(frames.writeBuffer().pixels, lastFrame, sizeof(lastFrame));
+        frames.publish();
+        lastFrameChange.store(now);
     }
     
     ledController.show();
     shiftRegister.updateAll();
-}
\ No newline at end of file
+}
+
+void OutputManager::bindTask(Scheduler& sched, int id) {
+    scheduler = &sched;
+    taskId = id;
+    scheduler->setPeriod(taskId, getRefreshInterval());
+}
+
+void OutputManager::flush() {
+    ledController.showRounded();
+}
+
+void OutputManager::setRefreshMode(RefreshMode mode) {
+    refreshMode = mode;
+    if (scheduler) scheduler->setPeriod(taskId, getRefreshInterval());
+}
+
+unsigned long OutputManager::getRefreshInterval() const {
+    if (refreshMode == RefreshMode::FAST) return FAST_REFRESH_MS;
+    return STANDARD_REFRESH_MS;
+}
+
+void OutputManager::checkTransitions(const StateSnapshot& state, unsigned long now) {
+    bool animating = state.animState.isAnimating;
+    uint8_t pattern = state.animState.pattern;
+
+    if (animating != lastAnimating) {
+        // Fade the animation layer in or out over the user's colors
+        compositor.fadeTo(Compositor::ANIMATION_LAYER, animating ? 255 : 0, MODE_FADE_MS, now);
+    } else if (animating && pattern != lastPattern) {
+        // Crossfade from the frozen old pattern into the new one
+        compositor.crossfade(PATTERN_FADE_MS, now);
+    }
+
+    lastAnimating = animating;
+    lastPattern = pattern;
+
+    if (state.animState.notifyCount != lastNotifyCount) {
+        // Flash the overlay on top of everything and let it fade away
+        Rgb16Color color = LEDUtils::hsvToRgb16(state.animState.notifyHue, 255, StateManager::MAX_BRIGHTNESS);
+        Rgb16Color* overlay = compositor.getLayer(Compositor::OVERLAY_LAYER);
+        for (int i = 0; i < Compositor::NUM_PIXELS; i++) overlay[i] = color;
+        compositor.setOpacity(Compositor::OVERLAY_LAYER, NOTIFY_OPACITY);
+        compositor.fadeTo(Compositor::OVERLAY_LAYER, 0, NOTIFY_FADE_MS, now);
+        lastNotifyCount = state.animState.notifyCount;
+    }
+}
+
+Rgb16Color OutputManager::renderState(const OutputState& state) {
+    if (!state.isOn) return {0, 0, 0};
+    return LEDUtils::hsvToRgb16(state.hue, 255, state.brightness);
+}
@@ -5,16 +5,71 @@
 #include "state_manager.h"
 #include "led_control.h"
 #include "shift_register.h"
+#include "compositor.h"
+#include "scheduler.h"
+
+// A composited frame, before gamma. Published for frame streaming, which
+// runs in the network task.
+struct Frame {
+    Rgb16Color pixels[Compositor::NUM_PIXELS];
+};
+
+// How often the strip is refreshed. FAST runs several refreshes per state tick
+// so temporal dithering averages out faster than the eye can follow.
+enum class RefreshMode {
+    STANDARD,   // Once per state tick
+    FAST        // Several refreshes per state tick, for dithering
+};
 
 class OutputManager {
 public:
-    void begin(StateManager& stateManager);
-    void update();  // Call this in loop() to update physical outputs
+    static const uint16_t MODE_FADE_MS = 600;     // Entering/leaving party mode
+    static const uint16_t PATTERN_FADE_MS = 400;  // Switching animation patterns
+    static const uint16_t NOTIFY_FADE_MS = 300;   // StateManager::notify() flash
+    static const uint8_t NOTIFY_OPACITY = 160;
+    static const unsigned long STANDARD_REFRESH_MS = 20;  // Matches the state tick
+    static const unsigned long FAST_REFRESH_MS = 4;       // 250 Hz
+
+    // Renders whatever StateManager last published to the buffer, so it can
+    // run on another core than the state tick
+    void begin(StateBuffer& states);
+    void update();  // Call every getRefreshInterval() ms to update physical outputs
+    // The task that calls update(), so setRefreshMode() can change its period
+    void bindTask(Scheduler& scheduler, int taskId);
+    // Last refresh before update() stops being called (idle): the frame
+    // rounded to 8 bits, as dithering would freeze on whichever step it was at
+    void flush();
+    Compositor& getCompositor() { return compositor; }  // Renderer side only
+    const Frame& readFrame() { return frames.read(); }  // Last changed frame, one reader
+    LEDController& getLEDController() { return ledController; }
+    ShiftRegisterController& getShiftRegister() { return shiftRegister; }
+    void setRefreshMode(RefreshMode mode);
+    RefreshMode getRefreshMode() const { return refreshMode; }
+    unsigned long getRefreshInterval() const;
+    unsigned long getLastFrameChange() const { return lastFrameChange.load(); }  // millis() of last visible change
 
 private:
-    StateManager* stateManager;
+    StateBuffer* states;
     LEDController ledController;
     ShiftRegisterController shiftRegister;
+    Compositor compositor;
+    Scheduler* scheduler = nullptr;
+    int taskId = -1;
+
+    bool lastAnimating = false;
+    uint8_t lastPattern = 0;
+    uint8_t lastNotifyCount = 0;
+#ifdef USE_TEMPORAL_DITHER
+    RefreshMode refreshMode = RefreshMode::FAST;
+#else
+    RefreshMode refreshMode = RefreshMode::STANDARD;
+#endif
+    Rgb16Color lastFrame[Compositor::NUM_PIXELS] = {};
+    SharedValue<unsigned long> lastFrameChange;
+    TripleBuffer<Frame> frames;
+
+    void checkTransitions(const StateSnapshot& state, unsigned long now);
+    static Rgb16Color renderState(const OutputState& state);
 };
 
-#endif
\ No newline at end of file
+#endif
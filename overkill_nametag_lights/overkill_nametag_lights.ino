@@ -8,12 +8,24 @@
 #include "shift_register.h"
 #include "state_manager.h"
 #include "output_manager.h"
+#include "scheduler.h"
+#include "power_manager.h"
+#include "audio_input.h"
+#include "audio_analyzer.h"
+#include "remote_control.h"
+#include "recorder.h"
+#include "diagnostics.h"
+#include "memory_monitor.h"
+#include "schedule.h"
+#include "schedule_runner.h"
 
 #define DEBUG_MODE
 #ifdef DEBUG_MODE
     #define DEBUG_PRINT(x) Serial.println(x)
+    #define DEBUG_PRINTF(...) Serial.printf(__VA_ARGS__)
 #else
     #define DEBUG_PRINT(x)
+    #define DEBUG_PRINTF(...)
 #endif
 
 /*
@@ -32,6 +44,8 @@ Example network message structure:
   "deviceId": "tag1",
   "sequence": 123,
   "timestamp": 1234567890,
+  "randomSeed": 3735928559,   // StateManager::setRandomSeed(seed, frame) so
+  "frame": 4521,              // random patterns match across badges
   "states": [{
     "index": 0,
     "isOn": true,
@@ -43,29 +57,49 @@ Example network message structure:
 }
 */
 
-String ap_ssid;      // Name for the WiFi network
+char ap_ssid[16];    // Name for the WiFi network
 const char* ap_password = "12345678";     // Password for the WiFi network
 
 ButtonManager buttonManager;
 StateManager stateManager;
+StateBuffer stateBuffer;         // State tick -> renderer
 OutputManager outputManager;
+Scheduler scheduler;
+PowerManager powerManager;
+AudioInput audioInput;
+AudioAnalyzer audioAnalyzer;
+RemoteControl remoteControl;
+Recorder recorder;
+Replayer replayer;
+Diagnostics diagnostics;
+Schedule schedule;
+ScheduleRunner scheduleRunner;
 
-String getUniqueSSID() {
+RefreshMode normalRefreshMode;   // Output task rate when not listening
+int audioTask = -1;              // Samples at the ADC rate while listening
+int analyzeTask = -1;            // Triggered by the audio task once a block is full
+
+void makeUniqueSSID(char* ssid, size_t size) {
     uint32_t chipId = ESP.getChipId();
-    char ssid[32];
-    snprintf(ssid, sizeof(ssid), "Nametag_%06X", chipId);  // Format chip ID as 6-digit hex
-    return String(ssid);
+    snprintf(ssid, size, "Nametag_%06X", chipId);  // Format chip ID as 6-digit hex
 }
 
-void setupOTA() {
-    // Configure access point
-    ap_ssid = getUniqueSSID();
+void startAccessPoint() {
     WiFi.mode(WIFI_AP);
     WiFi.softAP(ap_ssid, ap_password);
     
     DEBUG_PRINT("Access Point Started");
-    DEBUG_PRINT("SSID: " + String(ap_ssid));
-    DEBUG_PRINT("IP address: " + WiFi.softAPIP().toString());
+    DEBUG_PRINTF("SSID: %s\n", ap_ssid);
+    IPAddress ip = WiFi.softAPIP();
+    DEBUG_PRINTF("IP address: %u.%u.%u.%u\n", ip[0], ip[1], ip[2], ip[3]);
+    
+    remoteControl.listen();
+}
+
+void setupOTA() {
+    // Configure access point
+    makeUniqueSSID(ap_ssid, sizeof(ap_ssid));
+    startAccessPoint();
 
     // Configure OTA
     ArduinoOTA.setPassword("admin");      // OTA password
@@ -79,11 +113,11 @@ void setupOTA() {
     });
     
     ArduinoOTA.onProgress([](unsigned int progress, unsigned int total) {
-        DEBUG_PRINT("Progress: " + String((progress / (total / 100))) + "%");
+        DEBUG_PRINTF("Progress: %u%%\n", progress / (total / 100));
     });
     
     ArduinoOTA.onError([](ota_error_t error) {
-        DEBUG_PRINT("Error[" + String(error) + "]: ");
+        DEBUG_PRINTF("Error[%u]: \n", error);
         if (error == OTA_AUTH_ERROR) DEBUG_PRINT("Auth Failed");
         else if (error == OTA_BEGIN_ERROR) DEBUG_PRINT("Begin Failed");
         else if (error == OTA_CONNECT_ERROR) DEBUG_PRINT("Connect Failed");
@@ -95,52 +129,247 @@ void setupOTA() {
     DEBUG_PRINT("OTA Ready");
 }
 
+void handleButtonEvent(const ButtonEventData& event) {
+    stateManager.handleButtonEvent(event);
+    if (event.type == ButtonEvent::LONG_PRESSED && stateManager.isInAnimationMode()) {
+        DEBUG_PRINT(stateManager.isSoundReactive() ? "Sound reactive on" : "Sound reactive off");
+    }
+}
+
+#ifdef DEBUG_MODE
+const MemoryRegion MEMORY_REGIONS[] = {
+    {"buttons", sizeof(buttonManager)},
+    {"state", sizeof(stateManager)},
+    {"state_buffer", sizeof(stateBuffer)},
+    {"output", sizeof(outputManager)},
+    {"scheduler", sizeof(scheduler)},
+    {"power", sizeof(powerManager)},
+    {"audio_input", sizeof(audioInput)},
+    {"audio_analyzer", sizeof(audioAnalyzer)},
+    {"remote", sizeof(remoteControl)},
+    {"recorder", sizeof(recorder)},
+    {"replayer", sizeof(replayer)},
+    {"schedule", sizeof(schedule) + sizeof(scheduleRunner)},
+    {"diagnostics", sizeof(diagnostics)}
+};
+
+// Serial debug commands: d dumps the recording as hex, l loads a dump sent
+// back in the same format, r replays the recording (again to stop), c prints
+// pattern checksums, b runs the benchmarks, m prints the memory report.
+// Checks and benchmarks hold the CPU for a while and show up as overruns.
+void handleSerialCommands() {
+    static bool dumping = false;
+    static uint16_t dumpOffset = 0;
+    static bool loading = false;
+    static char line[80];
+    static uint8_t lineLength = 0;
+    
+    if (loading) {
+        while (Serial.available()) {
+            char c = Serial.read();
+            if (c != '\n') {
+                if (lineLength < sizeof(line) - 1) line[lineLength++] = c;
+                continue;
+            }
+            line[lineLength] = '\0';
+            lineLength = 0;
+            Recorder::LoadResult result = recorder.loadLine(line);
+            if (result == Recorder::LOAD_MORE) continue;
+            DEBUG_PRINT(result == Recorder::LOAD_DONE ? "Loaded, r replays it" : "Load failed");
+            loading = false;
+            break;
+        }
+        return;
+    }
+    
+    if (dumping) {
+        // A line per run keeps the task inside its budget
+        uint8_t chunk[32];
+        size_t length = recorder.read(dumpOffset, chunk, sizeof(chunk));
+        for (size_t i = 0; i < length; i++) Serial.printf("%02X", chunk[i]);
+        Serial.println();
+        dumpOffset += length;
+        if (length < sizeof(chunk)) {
+            Serial.println("END");
+            if (!replayer.isRunning()) recorder.setEnabled(true);
+            dumping = false;
+        }
+        return;
+    }
+    
+    if (!Serial.available()) return;
+    switch (Serial.read()) {
+        case 'd':
+            recorder.setEnabled(false);
+            Serial.printf("REC %u bytes\n", recorder.getSize());
+            dumpOffset = 0;
+            dumping = true;
+            break;
+            
+        case 'l':
+            if (replayer.isRunning()) replayer.stop();
+            recorder.beginLoad();
+            lineLength = 0;
+            loading = true;
+            DEBUG_PRINT("Send the dump, then END");
+            break;
+            
+        case 'r':
+            if (replayer.isRunning()) {
+                replayer.stop();
+                DEBUG_PRINT("Replay stopped");
+            } else {
+                DEBUG_PRINT(replayer.start() ? "Replaying" : "Nothing to replay");
+            }
+            break;
+            
+        case 'c':
+            diagnostics.checkPatterns(Serial);
+            break;
+            
+        case 'b':
+            diagnostics.runBenchmarks(Serial);
+            break;
+            
+        case 'm':
+            MemoryMonitor::printReport(Serial, MEMORY_REGIONS, sizeof(MEMORY_REGIONS) / sizeof(MEMORY_REGIONS[0]));
+            break;
+    }
+}
+#endif
+
+// Every refresh holds the audio task off for a few sample slots, so the
+// strip drops to the STANDARD refresh while listening; the music keeps
+// patterns moving anyway. Not listening, the audio task only checks the
+// mode once a tick, so loop() can still sleep between tasks.
+void setListening(bool listening) {
+    if (listening == audioInput.isRunning()) return;
+    if (listening) audioInput.start();
+    else audioInput.stop();
+    scheduler.setPeriodUs(audioTask, listening ? AudioInput::SAMPLE_PERIOD_US
+                                               : StateManager::UPDATE_INTERVAL_MS * 1000UL);
+    outputManager.setRefreshMode(listening ? RefreshMode::STANDARD : normalRefreshMode);
+}
+
+void setupTasks() {
+    // Render: advance the state tick, then push frames at the refresh rate
+    int stateTask = scheduler.addPeriodic("state", []() {
+        if (replayer.isRunning()) {
+            replayer.step(millis());
+            stateManager.publish(stateBuffer);
+            return;
+        }
+        recorder.tick(millis());
+        stateManager.update();
+        stateManager.publish(stateBuffer);
+    }, PRIORITY_RENDER, StateManager::UPDATE_INTERVAL_MS, 2000);
+    normalRefreshMode = outputManager.getRefreshMode();
+    int outputTask = scheduler.addPeriodic("output", []() { outputManager.update(); },
+                                           PRIORITY_RENDER, outputManager.getRefreshInterval(), 1000);
+    outputManager.bindTask(scheduler, outputTask);
+    
+    // Input: poll often enough for EventButton's debounce
+    int buttonTask = scheduler.addPeriodic("buttons", []() { buttonManager.update(); },
+                                           PRIORITY_INPUT, 2, 500);
+    
+    // Audio: sample only while sound reactive, one sample per run at the ADC
+    // rate, and analyze each full block in its own task so capture's small
+    // budget never has to wait out a render
+    audioTask = scheduler.addPeriodic("audio", []() {
+        setListening(stateManager.isInAnimationMode() && stateManager.isSoundReactive() &&
+                     !replayer.isRunning());
+        if (audioInput.poll()) scheduler.trigger(analyzeTask);
+    }, PRIORITY_INPUT, StateManager::UPDATE_INTERVAL_MS, 150);
+    analyzeTask = scheduler.addEvent("analyze", []() {
+        int16_t block[AudioInput::BLOCK_SIZE];
+        if (!audioInput.readBlock(block)) return;
+        audioAnalyzer.process(block);
+        stateManager.setAudioFeatures(audioAnalyzer.getFeatures());
+        recorder.recordAudio(audioAnalyzer.getFeatures());
+    }, PRIORITY_INPUT, 1500);
+    
+    // Network: remote control commands and live frame streaming
+    int remoteTask = scheduler.addPeriodic("remote", []() { remoteControl.poll(); },
+                                           PRIORITY_NETWORK, 5, 1500);
+    
+    // Housekeeping
+    scheduler.addPeriodic("schedule", []() {
+        if (!replayer.isRunning()) scheduleRunner.update();   // The recording is driving
+    }, PRIORITY_HOUSEKEEPING, 1000, 500);
+    int otaTask = scheduler.addPeriodic("ota", []() { ArduinoOTA.handle(); },
+                                        PRIORITY_HOUSEKEEPING, 20, 1000);
+#ifdef DEBUG_MODE
+    scheduler.addPeriodic("stats", []() {
+        scheduler.printStats(Serial);
+        const LEDController& leds = outputManager.getLEDController();
+        Serial.printf("LEDs: %u mA estimated, budget %u mA, output %u%%\n",
+                      (unsigned)leds.getEstimatedCurrent(), leds.getPowerBudget(), leds.getPowerLimitPercent());
+        if (audioInput.isRunning()) {
+            Serial.printf("Audio: %lu us/block (max %lu), %u samples held\n", audioAnalyzer.getLastProcessUs(),
+                          audioAnalyzer.getMaxProcessUs(), (unsigned)audioInput.getHeldSamples());
+        }
+        powerManager.printStats(Serial);
+    }, PRIORITY_HOUSEKEEPING, 10000, 3000);
+    int serialTask = scheduler.addPeriodic("serial", handleSerialCommands, PRIORITY_HOUSEKEEPING, 50, 2000);
+#endif
+    
+    // Nothing changes on screen while idle, and a press wakes us by interrupt
+    powerManager.begin(scheduler, buttonManager.getWakePins(), buttonManager.getWakePinCount(), startAccessPoint);
+    powerManager.suspendWhenIdle(stateTask);
+    powerManager.suspendWhenIdle(outputTask, []() { outputManager.flush(); });   // Not mid-dither
+    powerManager.suspendWhenIdle(audioTask);    // Never idle while listening, see loop()
+    if (buttonManager.getWakePinCount() > 0) {
+        powerManager.suspendWhenIdle(buttonTask);  // Scanned chains have to keep polling
+    }
+    // A button press is the only way back from light sleep
+    powerManager.suspendWhileRadioOff(remoteTask);
+    powerManager.suspendWhileRadioOff(otaTask);
+#ifdef DEBUG_MODE
+    powerManager.suspendWhileRadioOff(serialTask);
+#endif
+}
+
 void setup() {
+    Serial.setRxBufferSize(1024);  // Room for 50 ms of a dump upload between serial task runs
     Serial.begin(115200);
     DEBUG_PRINT("Starting up...");
     
     setupOTA();
     
     buttonManager.begin();
-    outputManager.begin(stateManager);
+    stateManager.setRandomSeed(ESP.random());  // Local seed until a mesh peer shares one
+    stateManager.publish(stateBuffer);
+    outputManager.begin(stateBuffer);
+    recorder.begin(stateManager);
+    recorder.recordSeed(stateManager.getRandomSeed(), stateManager.getFrameCount());
+    replayer.begin(recorder, stateManager, handleButtonEvent,
+                   [](uint8_t command, const uint8_t* payload, size_t length) {
+                       return remoteControl.applyCommand(command, payload, length);
+                   });
+    remoteControl.begin(stateManager, outputManager, powerManager, recorder, schedule);
+    scheduleRunner.begin(schedule, stateManager, powerManager, remoteControl, recorder);
+#ifdef DEBUG_MODE
+    diagnostics.begin(stateManager, outputManager, recorder);
+#endif
     
-    // Subscribe StateManager to button events
+    // Subscribe StateManager to button events, recorded for replay
     EventBus::subscribe([](const ButtonEventData& event) {
-        switch(event.type) {
-            case ButtonEvent::CLICKED:
-                if (!stateManager.isInAnimationMode()) {
-                    stateManager.toggleOutput(event.buttonIndex);
-                    DEBUG_PRINT("Toggling output");
-                } else {
-                    stateManager.setAnimationPattern(event.buttonIndex);
-                }
-                break;
-                
-            case ButtonEvent::DOUBLE_CLICKED:
-                stateManager.toggleAnimationMode();
-                break;
-                
-            case ButtonEvent::LONG_PRESSED:
-                if (!stateManager.isInAnimationMode()) {
-                    stateManager.setColorCycling(event.buttonIndex, true);
-                }
-                break;
-                
-            case ButtonEvent::LONG_PRESS_RELEASED:
-                if (!stateManager.isInAnimationMode()) {
-                    stateManager.setColorCycling(event.buttonIndex, false);
-                }
-                break;
-        }
+        if (replayer.isRunning()) return;  // The recording is driving
+        recorder.recordButton(event);
+        handleButtonEvent(event);
     });
     
     delay(2000);  // Initial delay for programming
+    
+    setupTasks();  // After the delay so nothing starts out late
+    
+    MemoryMonitor::lockHeap();  // Everything from here on runs from static memory
 }
 
 void loop() {
-    ArduinoOTA.handle();  // Handle OTA update requests
-    
-    buttonManager.update();
-    stateManager.update();
-    outputManager.update();
-    }
\ No newline at end of file
+    scheduler.runOnce();
+    // Listening counts as a change, or a quiet room would stop the microphone
+    powerManager.update(audioInput.isRunning() ? millis() : outputManager.getLastFrameChange());
+    powerManager.idle(scheduler.getIdleTimeUs());
+    MemoryMonitor::update();
+}
\ No newline at end of file
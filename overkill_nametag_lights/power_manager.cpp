@@ -0,0 +1,254 @@
+#include "power_manager.h"
+#include <ESP8266WiFi.h>
+
+extern "C" {
+    #include "user_interface.h"
+    #include "gpio.h"
+}
+
+volatile bool PowerManager::wakeRequested = false;
+volatile bool PowerManager::sleepEnded = false;
+
+void IRAM_ATTR PowerManager::onWakePin() {
+    wakeRequested = true;
+}
+
+void PowerManager::onSleepEnd() {
+    sleepEnded = true;
+}
+
+void PowerManager::begin(Scheduler& sched, const int* pins, int pinCount, WifiRestoreFunction restore) {
+    scheduler = &sched;
+    restoreWifi = restore;
+    wakePinCount = min(pinCount, (int)MAX_WAKE_PINS);
+    for (int i = 0; i < wakePinCount; i++) {
+        wakePins[i] = pins[i];
+        // Buttons pull low when pressed
+        attachInterrupt(digitalPinToInterrupt(wakePins[i]), onWakePin, FALLING);
+    }
+    activeSince = millis();
+    accountedAt = micros();
+    WiFi.setSleepMode(WIFI_NONE_SLEEP);    // Full radio while active, for streaming and OTA
+}
+
+void PowerManager::suspendWhenIdle(int taskId, TaskFunction beforeSuspend) {
+    if (taskId < 0 || suspendedCount >= Scheduler::MAX_TASKS) return;
+    suspendHooks[suspendedCount] = beforeSuspend;
+    suspendedTasks[suspendedCount++] = taskId;
+}
+
+void PowerManager::suspendWhileRadioOff(int taskId) {
+    if (taskId < 0 || radioTaskCount >= Scheduler::MAX_TASKS) return;
+    radioTasks[radioTaskCount++] = taskId;
+}
+
+void PowerManager::wake() {
+    wakeRequested = true;
+}
+
+void PowerManager::beginBlackout(unsigned long durationMs) {
+    unsigned long now = millis();
+    blackout = true;
+    blackoutStart = clockMs();
+    blackoutMs = durationMs;
+
+    // Straight to sleep, whoever is connected
+    if (state == PowerState::ACTIVE) enterIdle(now);
+    if (state == PowerState::IDLE) enterLightSleep();
+}
+
+void PowerManager::endBlackout() {
+    blackout = false;
+    wakeRequested = true;
+}
+
+void PowerManager::update(unsigned long lastFrameChange) {
+    unsigned long now = millis();
+    account();
+
+    if (wakeRequested) {
+        wakeRequested = false;
+        blackout = false;
+        if (state != PowerState::ACTIVE) {
+            enterActive(now);
+        }
+        activeSince = now;  // Any press restarts the idle countdown
+        return;
+    }
+
+    switch (state) {
+        case PowerState::ACTIVE:
+            // Static since the later of the last change and waking up
+            if (now - lastFrameChange >= IDLE_AFTER_MS && now - activeSince >= IDLE_AFTER_MS) {
+                enterIdle(now);
+            }
+            break;
+
+        case PowerState::IDLE:
+            // Keep the AP up while anyone is connected (OTA, remote control)
+            // and only when a button can wake us again
+            if (now - idleSince >= SLEEP_AFTER_MS && wakePinCount > 0 &&
+                WiFi.softAPgetStationNum() == 0) {
+                enterLightSleep();
+            }
+            break;
+
+        case PowerState::LIGHT_SLEEP:
+            break;
+    }
+}
+
+void PowerManager::idle(unsigned long idleUs) {
+    unsigned long idleMs = idleUs / 1000;
+    account();
+
+    switch (state) {
+        case PowerState::ACTIVE:
+            // Yield until the next task instead of spinning
+            if (idleMs > 0) delay(idleMs);
+            break;
+
+        case PowerState::IDLE:
+            // Short naps so a press is picked up within a frame
+            if (idleMs > MAX_NAP_MS) idleMs = MAX_NAP_MS;
+            delay(idleMs > 0 ? idleMs : 1);
+            break;
+
+        case PowerState::LIGHT_SLEEP:
+            if (blackout) {
+                // Sleep to the end of the blackout rather than the next task
+                unsigned long elapsed = clockMs() - blackoutStart;
+                idleMs = elapsed < blackoutMs ? blackoutMs - elapsed : 0;
+                if (idleMs > MAX_BLACKOUT_SLEEP_MS) idleMs = MAX_BLACKOUT_SLEEP_MS;
+                // Without wake pins, presses are only seen between sleeps
+                if (wakePinCount == 0 && idleMs > MAX_LIGHT_SLEEP_MS) idleMs = MAX_LIGHT_SLEEP_MS;
+            } else if (idleMs > MAX_LIGHT_SLEEP_MS) {
+                idleMs = MAX_LIGHT_SLEEP_MS;
+            }
+            if (idleMs < MIN_LIGHT_SLEEP_MS) {
+                delay(idleMs > 0 ? idleMs : 1);   // Radio is off anyway
+            } else {
+                lightSleep(idleMs);
+            }
+            break;
+    }
+}
+
+void PowerManager::enterIdle(unsigned long now) {
+    for (int i = 0; i < suspendedCount; i++) {
+        if (suspendHooks[i]) suspendHooks[i]();
+    }
+    setTasksEnabled(scheduler, suspendedTasks, suspendedCount, false);
+    // Lets the SDK power the radio down between beacons where the WiFi
+    // mode allows it
+    WiFi.setSleepMode(WIFI_MODEM_SLEEP);
+    state = PowerState::IDLE;
+    idleSince = now;
+}
+
+void PowerManager::enterLightSleep() {
+    setTasksEnabled(scheduler, radioTasks, radioTaskCount, false);
+    WiFi.mode(WIFI_OFF);
+    WiFi.forceSleepBegin();
+    delay(1);
+    state = PowerState::LIGHT_SLEEP;
+}
+
+void PowerManager::enterActive(unsigned long now) {
+    if (state == PowerState::LIGHT_SLEEP) {
+        WiFi.forceSleepWake();
+        delay(1);
+        if (restoreWifi) restoreWifi();
+        setTasksEnabled(scheduler, radioTasks, radioTaskCount, true);
+    }
+    WiFi.setSleepMode(WIFI_NONE_SLEEP);
+    setTasksEnabled(scheduler, suspendedTasks, suspendedCount, true);
+    state = PowerState::ACTIVE;
+    activeSince = now;
+}
+
+void PowerManager::lightSleep(unsigned long durationMs) {
+    // Forced light sleep: CPU and radio stop until the timer or a button
+    wifi_set_opmode_current(NULL_MODE);
+    wifi_fpm_set_sleep_type(LIGHT_SLEEP_T);
+    wifi_fpm_open();
+    for (int i = 0; i < wakePinCount; i++) {
+        gpio_pin_wakeup_enable(GPIO_ID_PIN(wakePins[i]), GPIO_PIN_INTR_LOLEVEL);
+    }
+    uint32_t rtcStart = system_get_rtc_time();
+    unsigned long microsStart = micros();
+    sleepEnded = false;
+    wifi_fpm_set_wakeup_cb(onSleepEnd);
+    wifi_fpm_do_sleep(durationMs * 1000);
+    // Sleep actually starts once we yield. delay()'s timer runs on through
+    // it, so after a button wakes us early one long delay() would wait out
+    // the rest; short ones stop as soon as the wakeup callback has run.
+    for (unsigned long waited = 0; !sleepEnded && waited <= durationMs; waited++) {
+        delay(1);
+    }
+
+    // Add back what micros() missed. The RTC period is in us, 12 fractional
+    // bits, and drifts with temperature, so calibrate every time.
+    uint64_t sleptUs = ((uint64_t)(system_get_rtc_time() - rtcStart) * system_rtc_clock_cali_proc()) >> 12;
+    unsigned long countedUs = micros() - microsStart;
+    if (sleptUs > countedUs) {
+        missedUs += sleptUs - countedUs;
+        scheduler->skipAhead(sleptUs - countedUs);
+    }
+    stats.sleptUs += sleptUs;
+    stats.sleeps++;
+    accountedAt = micros();     // Asleep, not awake
+
+    gpio_pin_wakeup_disable();
+    wifi_fpm_close();
+
+    // A pin wakeup does not always fire the edge interrupt, so check directly
+    for (int i = 0; i < wakePinCount; i++) {
+        if (digitalRead(wakePins[i]) == LOW) {
+            wakeRequested = true;
+        }
+    }
+}
+
+
+const PowerStats& PowerManager::getStats() {
+    account();
+    return stats;
+}
+
+uint32_t PowerManager::getAverageMicroamps() {
+    account();
+    static const uint32_t STATE_UA[] = {ACTIVE_MA * 1000UL, IDLE_MA * 1000UL, RADIO_OFF_MA * 1000UL};
+    uint64_t chargeUaUs = stats.sleptUs * LIGHT_SLEEP_UA;   // uA x us
+    uint64_t totalUs = stats.sleptUs;
+    for (int i = 0; i < 3; i++) {
+        chargeUaUs += stats.awakeUs[i] * STATE_UA[i];
+        totalUs += stats.awakeUs[i];
+    }
+    return totalUs > 0 ? (uint32_t)(chargeUaUs / totalUs) : 0;
+}
+
+void PowerManager::printStats(Print& out) {
+    uint32_t averageUa = getAverageMicroamps();
+    out.printf("Power: active %lu s, idle %lu s, radio off %lu s, asleep %lu s in %u sleeps, ~%u.%u mA\n",
+               (unsigned long)(stats.awakeUs[0] / 1000000), (unsigned long)(stats.awakeUs[1] / 1000000),
+               (unsigned long)(stats.awakeUs[2] / 1000000), (unsigned long)(stats.sleptUs / 1000000),
+               (unsigned)stats.sleeps, (unsigned)(averageUa / 1000), (unsigned)(averageUa % 1000 / 100));
+}
+
+void PowerManager::resetStats() {
+    stats = {};
+    accountedAt = micros();
+}
+
+void PowerManager::account() {
+    unsigned long now = micros();
+    stats.awakeUs[(int)state] += now - accountedAt;
+    accountedAt = now;
+}
+
+void PowerManager::setTasksEnabled(Scheduler* scheduler, const int* ids, uint8_t count, bool enabled) {
+    for (int i = 0; i < count; i++) {
+        scheduler->setEnabled(ids[i], enabled);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,109 @@
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <Arduino.h>
+#include "scheduler.h"
+
+enum class PowerState {
+    ACTIVE,         // Normal rendering
+    IDLE,           // Frame is static: render and input tasks suspended, CPU naps, modem sleep
+    LIGHT_SLEEP     // Idle with no AP clients: WiFi off and network tasks suspended, forced light sleep
+};
+
+// Where the time went since begin() or resetStats()
+struct PowerStats {
+    uint64_t awakeUs[3];    // Per PowerState, CPU running
+    uint64_t sleptUs;       // Forced light sleep, by the RTC
+    uint32_t sleeps;
+};
+
+// Drops the badge into low power states when nothing on it is changing and
+// brings it back on a button press (pin interrupt / GPIO wakeup).
+class PowerManager {
+public:
+    static const unsigned long IDLE_AFTER_MS = 2000;        // Static frame time before idling
+    static const unsigned long SLEEP_AFTER_MS = 120000;     // Idle time with no AP clients before light sleep
+    static const unsigned long MAX_NAP_MS = 20;             // One frame, bounds wake latency while idle
+    static const unsigned long MAX_LIGHT_SLEEP_MS = 10000;  // Re-check the schedule at least this often
+    static const unsigned long MAX_BLACKOUT_SLEEP_MS = 268000;  // Longest forced light sleep the SDK takes
+    static const unsigned long MIN_LIGHT_SLEEP_MS = 50;     // Shorter waits nap; a sleep stops and restarts the clocks
+    static const uint8_t MAX_WAKE_PINS = 8;
+
+    // Module current estimates (LEDs not included), for the stats
+    static const uint16_t ACTIVE_MA = 75;       // Radio on
+    static const uint16_t IDLE_MA = 25;         // Modem sleep, CPU napping
+    static const uint16_t RADIO_OFF_MA = 15;    // Awake between light sleeps
+    static const uint16_t LIGHT_SLEEP_UA = 900;
+
+    using WifiRestoreFunction = void (*)();
+
+    void begin(Scheduler& scheduler, const int* wakePins, int pinCount, WifiRestoreFunction restoreWifi);
+
+    // Tasks to pause while idle (render, button polling, audio).
+    // beforeSuspend runs once each time, just before the task stops.
+    void suspendWhenIdle(int taskId, TaskFunction beforeSuspend = nullptr);
+    // Tasks with nothing to do without the radio (network, OTA, serial)
+    void suspendWhileRadioOff(int taskId);
+
+    // Call after each scheduler pass with the time of the last visible change
+    void update(unsigned long lastFrameChange);
+
+    // Sleep for as much of idleUs as the current state allows
+    void idle(unsigned long idleUs);
+
+    // Something needs the badge awake (button, remote command)
+    void wake();
+
+    // Scheduled blackout: light sleep with the radio off for durationMs, in
+    // as few wakeups as the hardware allows. Calling again moves the end.
+    // A button press ends it early.
+    void beginBlackout(unsigned long durationMs);
+    void endBlackout();
+    bool isInBlackout() const { return blackout; }
+
+    PowerState getState() const { return state; }
+
+    // millis() plus the forced light sleep it missed (the CPU clock stops,
+    // the RTC timer keeps counting). The clock for the schedule and blackouts.
+    unsigned long clockMs() const { return millis() + (unsigned long)(missedUs / 1000); }
+
+    const PowerStats& getStats();
+    uint32_t getAverageMicroamps();
+    void printStats(Print& out);
+    void resetStats();
+
+private:
+    Scheduler* scheduler = nullptr;
+    WifiRestoreFunction restoreWifi = nullptr;
+    int wakePins[MAX_WAKE_PINS];
+    uint8_t wakePinCount = 0;
+    int suspendedTasks[Scheduler::MAX_TASKS];
+    TaskFunction suspendHooks[Scheduler::MAX_TASKS];
+    uint8_t suspendedCount = 0;
+    int radioTasks[Scheduler::MAX_TASKS];
+    uint8_t radioTaskCount = 0;
+
+    PowerState state = PowerState::ACTIVE;
+    unsigned long activeSince = 0;
+    unsigned long idleSince = 0;
+    bool blackout = false;
+    unsigned long blackoutStart = 0;
+    unsigned long blackoutMs = 0;
+    uint64_t missedUs = 0;
+    PowerStats stats = {};
+    unsigned long accountedAt = 0;     // micros() of the last stats update
+
+    static volatile bool wakeRequested;
+    static void IRAM_ATTR onWakePin();
+    static volatile bool sleepEnded;    // Forced light sleep over, timer or pin
+    static void onSleepEnd();
+
+    void enterIdle(unsigned long now);
+    void enterLightSleep();
+    void enterActive(unsigned long now);
+    void lightSleep(unsigned long durationMs);
+    void account();     // Charge the time since the last call to the current state
+    static void setTasksEnabled(Scheduler* scheduler, const int* ids, uint8_t count, bool enabled);
+};
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef PRNG_H
+#define PRNG_H
+
+#include <Arduino.h>
+
+// Small xorshift32 generator. Much cheaper than Arduino random() (no modulo,
+// no 32-bit LCG per byte) and fully determined by its seed, so badges sharing
+// a seed produce the same random patterns.
+class Prng {
+public:
+    explicit Prng(uint32_t seed = 1) { setSeed(seed); }
+
+    void setSeed(uint32_t seed) {
+        state = seed ? seed : 0x6D2B79F5;  // xorshift must never be seeded with zero
+    }
+
+    uint32_t next32() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    uint8_t next8() {
+        return next32() >> 24;  // High bits are the best mixed
+    }
+
+    // 0 to max-1, by multiply-shift instead of modulo
+    uint8_t next8(uint8_t max) {
+        return ((uint16_t)next8() * max) >> 8;
+    }
+
+    // min to max-1, same range as Arduino random(min, max)
+    uint8_t next8(uint8_t min, uint8_t max) {
+        return min + next8(max - min);
+    }
+
+    // Bulk fill for a whole frame's worth of random bytes, 4 bytes per step
+    void fill(uint8_t* buffer, size_t length) {
+        while (length >= 4) {
+            uint32_t r = next32();
+            buffer[0] = r;
+            buffer[1] = r >> 8;
+            buffer[2] = r >> 16;
+            buffer[3] = r >> 24;
+            buffer += 4;
+            length -= 4;
+        }
+        if (length > 0) {
+            uint32_t r = next32();
+            while (length--) {
+                *buffer++ = r;
+                r >>= 8;
+            }
+        }
+    }
+
+    // Derive a well-mixed seed for a given frame from a shared base seed
+    static uint32_t seedForFrame(uint32_t seed, uint32_t frame) {
+        uint32_t h = seed ^ (frame * 0x9E3779B9);
+        h ^= h >> 16;
+        h *= 0x85EBCA6B;
+        h ^= h >> 13;
+        h *= 0xC2B2AE35;
+        h ^= h >> 16;
+        return h;
+    }
+
+private:
+    uint32_t state;
+};
+
+#endif
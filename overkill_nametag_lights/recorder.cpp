@@ -0,0 +1,306 @@
+#include "recorder.h"
+
+static inline uint16_t readU16(const uint8_t* p) {
+    return p[0] | (p[1] << 8);
+}
+
+static inline uint32_t readU32(const uint8_t* p) {
+    return (uint32_t)readU16(p) | ((uint32_t)readU16(p + 2) << 16);
+}
+
+void Recorder::begin(StateManager& sm) {
+    stateManager = &sm;
+}
+
+void Recorder::tick(unsigned long now) {
+    if (!enabled || !stateManager) return;
+
+    // A late tick is what a stutter looks like from here
+    if (ticking && now - lastTick > 2 * StateManager::UPDATE_INTERVAL_MS) {
+        unsigned long gap = now - lastTick;
+        if (gap > 0xFFFF) gap = 0xFFFF;
+        if (beginRecord(REC_STALL, 2)) {
+            uint8_t data[2] = {(uint8_t)gap, (uint8_t)(gap >> 8)};
+            put(data, sizeof(data));
+        }
+    }
+    lastTick = now;
+    ticking = true;
+
+    if (ticksSinceKeyframe >= KEYFRAME_TICKS || bytesSinceKeyframe >= BUFFER_SIZE / 2) {
+        stateManager->saveSnapshot(scratch);
+        if (beginRecord(REC_KEYFRAME, sizeof(scratch))) put(&scratch, sizeof(scratch));
+        ticksSinceKeyframe = 0;
+        bytesSinceKeyframe = 0;
+    }
+    ticksSinceRecord++;
+    ticksSinceKeyframe++;
+}
+
+void Recorder::recordSeed(uint32_t seed, uint32_t frame) {
+    if (!enabled || !beginRecord(REC_SEED, 8)) return;
+    uint8_t data[8];
+    for (int i = 0; i < 4; i++) {
+        data[i] = seed >> (8 * i);
+        data[4 + i] = frame >> (8 * i);
+    }
+    put(data, sizeof(data));
+}
+
+void Recorder::recordButton(const ButtonEventData& event) {
+    if (!enabled || !beginRecord(REC_BUTTON, 1)) return;
+    uint8_t data = ((uint8_t)event.type << 6) | (event.buttonIndex & 0x3F);
+    put(&data, 1);
+}
+
+void Recorder::recordCommand(uint8_t command, const uint8_t* payload, size_t length) {
+    if (!enabled || length + 1 > MAX_COMMAND_SIZE) return;
+    uint8_t size = length + 1;
+    if (!beginRecord(REC_COMMAND, 1 + size)) return;
+    put(&size, 1);
+    put(&command, 1);
+    put(payload, length);
+}
+
+void Recorder::recordAudio(const AudioFeatures& features) {
+    if (!enabled || !beginRecord(REC_AUDIO, AudioFeatures::NUM_BANDS + 2)) return;
+    uint8_t tail[2] = {features.level, features.beat};
+    put(features.bands, AudioFeatures::NUM_BANDS);
+    put(tail, sizeof(tail));
+}
+
+void Recorder::setEnabled(bool enabled) {
+    if (enabled && !this->enabled) {
+        // Whatever ran while paused is missing, so restart from a keyframe
+        ticksSinceKeyframe = KEYFRAME_TICKS;
+        ticking = false;
+    }
+    this->enabled = enabled;
+}
+
+void Recorder::clear() {
+    tail = 0;
+    used = 0;
+    ticksSinceRecord = 0;
+    ticksSinceKeyframe = KEYFRAME_TICKS;
+    bytesSinceKeyframe = 0;
+    ticking = false;
+}
+
+size_t Recorder::read(uint16_t offset, uint8_t* out, size_t length) const {
+    if (offset >= used) return 0;
+    if (length > (size_t)(used - offset)) length = used - offset;
+    for (size_t i = 0; i < length; i++) {
+        out[i] = peek(offset + i);
+    }
+    return length;
+}
+
+bool Recorder::load(const uint8_t* data, size_t length) {
+    if (length > BUFFER_SIZE) return false;
+    beginLoad();
+    put(data, length);
+    if (isWellFormed()) return true;
+    clear();
+    return false;
+}
+
+void Recorder::beginLoad() {
+    enabled = false;  // Keep it intact for the replay
+    clear();
+}
+
+static int hexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+Recorder::LoadResult Recorder::loadLine(const char* line) {
+    while (*line == ' ' || *line == '\t') line++;
+    if (strncmp(line, "END", 3) == 0) {
+        if (isWellFormed()) return LOAD_DONE;
+        clear();
+        return LOAD_FAILED;
+    }
+    if (strncmp(line, "REC", 3) == 0) return LOAD_MORE;  // Size header of the dump
+
+    for (; *line && *line != '\r' && *line != '\n'; line += 2) {
+        int high = hexDigit(line[0]);
+        int low = high < 0 ? -1 : hexDigit(line[1]);
+        if (low < 0 || used >= BUFFER_SIZE) {
+            clear();
+            return LOAD_FAILED;
+        }
+        uint8_t byte = (high << 4) | low;
+        put(&byte, 1);
+    }
+    return LOAD_MORE;
+}
+
+bool Recorder::readRecord(uint16_t& cursor, Record& record, uint8_t* payload) const {
+    if (cursor + HEADER_SIZE > used) return false;
+    record.type = peek(cursor);
+    record.ticks = peek(cursor + 1) | (peek(cursor + 2) << 8);
+    record.length = payloadLength(record.type, peek(cursor + HEADER_SIZE));
+    if (record.length == 0 || record.length > MAX_PAYLOAD_SIZE ||
+        cursor + HEADER_SIZE + record.length > used) {
+        return false;
+    }
+    read(cursor + HEADER_SIZE, payload, record.length);
+    cursor += HEADER_SIZE + record.length;
+    return true;
+}
+
+bool Recorder::beginRecord(uint8_t type, uint16_t length) {
+    uint16_t size = HEADER_SIZE + length;
+    if (size > BUFFER_SIZE) return false;
+    while (BUFFER_SIZE - used < size) {
+        dropOldest();
+    }
+    bytesSinceKeyframe += size;
+    uint8_t header[HEADER_SIZE] = {type, (uint8_t)ticksSinceRecord, (uint8_t)(ticksSinceRecord >> 8)};
+    put(header, HEADER_SIZE);
+    ticksSinceRecord = 0;
+    return true;
+}
+
+void Recorder::put(const void* data, size_t length) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < length; i++) {
+        buffer[(tail + used) % BUFFER_SIZE] = bytes[i];
+        used++;
+    }
+}
+
+uint16_t Recorder::payloadLength(uint8_t type, uint8_t first) {
+    switch (type) {
+        case REC_SEED: return 8;
+        case REC_BUTTON: return 1;
+        case REC_COMMAND: return 1 + first;
+        case REC_AUDIO: return AudioFeatures::NUM_BANDS + 2;
+        case REC_STALL: return 2;
+        case REC_KEYFRAME: return sizeof(StateSnapshot);
+        default: return 0;
+    }
+}
+
+void Recorder::dropOldest() {
+    uint16_t size = HEADER_SIZE + payloadLength(peek(0), peek(HEADER_SIZE));
+    tail = (tail + size) % BUFFER_SIZE;
+    used -= size;
+}
+
+// Only streams that parse as whole records are replayable
+bool Recorder::isWellFormed() const {
+    uint16_t offset = 0;
+    while (offset < used) {
+        if (offset + HEADER_SIZE > used) return false;
+        uint8_t first = offset + HEADER_SIZE < used ? peek(offset + HEADER_SIZE) : 0;
+        uint16_t payload = payloadLength(peek(offset), first);
+        if (payload == 0) return false;
+        offset += HEADER_SIZE + payload;
+    }
+    return offset == used;
+}
+
+void Replayer::begin(Recorder& rec, StateManager& sm, ButtonHandler buttonHandler, CommandHandler commandHandler) {
+    recorder = &rec;
+    stateManager = &sm;
+    onButton = buttonHandler;
+    onCommand = commandHandler;
+}
+
+bool Replayer::start() {
+    if (running) stop();
+    recorder->setEnabled(false);
+
+    // Nothing before the first keyframe can be replayed
+    cursor = 0;
+    while (next()) {
+        if (record.type != Recorder::REC_KEYFRAME) continue;
+        apply();
+        pending = next();
+        ticksUntilRecord = pending ? record.ticks : 0;
+        holdMs = 0;
+        ticks = 0;
+        running = true;
+        return true;
+    }
+    recorder->setEnabled(true);
+    return false;
+}
+
+void Replayer::stop() {
+    running = false;
+    recorder->setEnabled(true);
+}
+
+void Replayer::step(unsigned long now) {
+    if (!running) return;
+    if (holdMs > 0) {
+        if (now - holdStart < holdMs) return;
+        holdMs = 0;
+    }
+
+    while (ticksUntilRecord == 0) {
+        if (!pending) {
+            stop();
+            return;
+        }
+        apply();
+        pending = next();
+        if (pending) ticksUntilRecord = record.ticks;
+        if (holdMs > 0) {
+            holdStart = now;  // Replay the stall, then this tick
+            return;
+        }
+    }
+    ticksUntilRecord--;
+    stateManager->update();
+    ticks++;
+}
+
+bool Replayer::next() {
+    return recorder->readRecord(cursor, record, payload);
+}
+
+void Replayer::apply() {
+    switch (record.type) {
+        case Recorder::REC_SEED:
+            stateManager->setRandomSeed(readU32(payload), readU32(payload + 4));
+            break;
+
+        case Recorder::REC_BUTTON: {
+            ButtonEventData event = {(ButtonEvent)(payload[0] >> 6), payload[0] & 0x3F};
+            if (onButton) onButton(event);
+            break;
+        }
+
+        case Recorder::REC_COMMAND:
+            if (onCommand && payload[0] > 0) onCommand(payload[1], payload + 2, payload[0] - 1);
+            break;
+
+        case Recorder::REC_AUDIO: {
+            AudioFeatures features;
+            memcpy(features.bands, payload, AudioFeatures::NUM_BANDS);
+            features.level = payload[AudioFeatures::NUM_BANDS];
+            features.beat = payload[AudioFeatures::NUM_BANDS + 1];
+            stateManager->setAudioFeatures(features);
+            break;
+        }
+
+        case Recorder::REC_STALL: {
+            // The normal tick interval passes between steps anyway
+            unsigned long gap = readU16(payload);
+            holdMs = 0;
+            if (gap > StateManager::UPDATE_INTERVAL_MS) holdMs = gap - StateManager::UPDATE_INTERVAL_MS;
+            break;
+        }
+
+        case Recorder::REC_KEYFRAME:
+            stateManager->restoreSnapshot(*reinterpret_cast<const StateSnapshot*>(payload));
+            break;
+    }
+}
\ No newline at end of file
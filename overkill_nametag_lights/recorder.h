@@ -0,0 +1,157 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <Arduino.h>
+#include "events.h"
+#include "state_manager.h"
+#include "audio_analyzer.h"
+
+/*
+Binary flight recorder for reproducing field bugs (little endian):
+
+  Record:   type | ticks (u16) | payload
+
+  SEED      seed (u32), frame (u32)
+  BUTTON    event type << 6 | button index
+  COMMAND   length, remote command byte, command payload
+  AUDIO     bands (8), level, beat
+  STALL     gap ms (u16), a state tick that ran late
+  KEYFRAME  StateSnapshot
+
+"ticks" counts state updates since the previous record, so a replay that
+starts from a keyframe and applies each record after that many updates
+reproduces every frame. Records live in a ring buffer and the oldest are
+dropped whole when it fills. A keyframe is written every KEYFRAME_TICKS and
+after every half buffer of records, so busy input (audio runs ~1 KB/s)
+never evicts the last one. Keyframes are raw StateSnapshot bytes, so a
+dump only replays on a build with the same NAMETAG_NUM_OUTPUTS.
+
+Dumps travel as text: lines of hex bytes, oldest first, then END (serial
+'d' output). loadLine() takes the same lines back, on the device (serial
+'l') or on a desktop (host/tools/replay.cpp).
+*/
+
+class Recorder {
+public:
+    static const uint16_t BUFFER_SIZE = 4096;
+    static const uint16_t HEADER_SIZE = 3;
+    static const uint16_t KEYFRAME_TICKS = 1500;    // 30 s of state updates
+    static const uint16_t MAX_COMMAND_SIZE = 16;
+    static const uint16_t MAX_PAYLOAD_SIZE = sizeof(StateSnapshot);
+
+    // The next keyframe has to be complete before the previous one reaches
+    // the tail, with room to spare for the records of one tick
+    static_assert(4 * (HEADER_SIZE + MAX_PAYLOAD_SIZE) <= BUFFER_SIZE, "Keyframes too big for the ring");
+
+    enum RecordType : uint8_t {
+        REC_SEED = 1,
+        REC_BUTTON = 2,
+        REC_COMMAND = 3,
+        REC_AUDIO = 4,
+        REC_STALL = 5,
+        REC_KEYFRAME = 6
+    };
+
+    enum LoadResult : uint8_t {
+        LOAD_MORE,      // Line taken, send the next one
+        LOAD_DONE,      // END seen and the recording parses
+        LOAD_FAILED     // Bad line or a dump that doesn't parse, buffer cleared
+    };
+
+    struct Record {
+        uint8_t type;
+        uint16_t ticks;
+        uint16_t length;    // Payload bytes
+    };
+
+    void begin(StateManager& stateManager);
+
+    // Call from the state task right before StateManager::update()
+    void tick(unsigned long now);
+
+    void recordSeed(uint32_t seed, uint32_t frame);
+    void recordButton(const ButtonEventData& event);
+    void recordCommand(uint8_t command, const uint8_t* payload, size_t length);
+    void recordAudio(const AudioFeatures& features);
+
+    // Paused while dumping or replaying so the buffer holds still
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return enabled; }
+    void clear();
+
+    // The recording as one byte stream, oldest record first
+    uint16_t getSize() const { return used; }
+    size_t read(uint16_t offset, uint8_t* out, size_t length) const;
+    bool load(const uint8_t* data, size_t length);  // Replace with a dump
+
+    // Replace with a text dump, one line at a time. Recording stays paused
+    // afterwards so the loaded dump can be replayed.
+    void beginLoad();
+    LoadResult loadLine(const char* line);
+
+    // Walk records: cursor starts at 0 and advances past each record read
+    bool readRecord(uint16_t& cursor, Record& record, uint8_t* payload) const;
+
+private:
+    StateManager* stateManager = nullptr;
+    uint8_t buffer[BUFFER_SIZE];
+    uint16_t tail = 0;      // Oldest record
+    uint16_t used = 0;
+    bool enabled = true;
+
+    uint16_t ticksSinceRecord = 0;
+    uint16_t ticksSinceKeyframe = KEYFRAME_TICKS;  // First tick writes one
+    uint16_t bytesSinceKeyframe = 0;
+    unsigned long lastTick = 0;
+    bool ticking = false;
+    StateSnapshot scratch;
+
+    bool beginRecord(uint8_t type, uint16_t length);
+    void put(const void* data, size_t length);
+    uint8_t peek(uint16_t offset) const { return buffer[(tail + offset) % BUFFER_SIZE]; }
+    static uint16_t payloadLength(uint8_t type, uint8_t first);
+    void dropOldest();
+    bool isWellFormed() const;
+};
+
+// Plays a recording back through StateManager, tick for tick, from its
+// first keyframe. Buttons and remote commands go through the same handlers
+// as live input.
+class Replayer {
+public:
+    using ButtonHandler = void (*)(const ButtonEventData& event);
+    using CommandHandler = uint8_t (*)(uint8_t command, const uint8_t* payload, size_t length);
+
+    void begin(Recorder& recorder, StateManager& stateManager,
+               ButtonHandler onButton, CommandHandler onCommand);
+
+    bool start();  // False if no keyframe was recorded
+    void stop();
+    bool isRunning() const { return running; }
+
+    // Call in place of StateManager::update() while running
+    void step(unsigned long now);
+
+    uint32_t getTickCount() const { return ticks; }
+
+private:
+    Recorder* recorder = nullptr;
+    StateManager* stateManager = nullptr;
+    ButtonHandler onButton = nullptr;
+    CommandHandler onCommand = nullptr;
+
+    bool running = false;
+    uint16_t cursor = 0;
+    Recorder::Record record;
+    uint16_t ticksUntilRecord = 0;
+    unsigned long holdStart = 0;
+    unsigned long holdMs = 0;
+    uint32_t ticks = 0;
+    bool pending = false;   // record holds the next record to apply
+    alignas(StateSnapshot) uint8_t payload[Recorder::MAX_PAYLOAD_SIZE];
+
+    bool next();
+    void apply();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,255 @@
+#include "remote_control.h"
+
+static inline uint16_t readU16(const uint8_t* p) {
+    return p[0] | (p[1] << 8);
+}
+
+static inline uint32_t readU32(const uint8_t* p) {
+    return readU16(p) | ((uint32_t)readU16(p + 2) << 16);
+}
+
+static inline void writeU16(uint8_t* p, uint16_t value) {
+    p[0] = value;
+    p[1] = value >> 8;
+}
+
+// Commands that change what the badge shows or does. Queries and clock
+// syncs are answered from IDLE, so a phone polling the state doesn't keep
+// the strip rendering.
+static bool wakesBadge(uint8_t command) {
+    switch (command) {
+        case RemoteControl::CMD_SET_OUTPUT:
+        case RemoteControl::CMD_SET_PATTERN:
+        case RemoteControl::CMD_SET_MODE:
+        case RemoteControl::CMD_STREAM:
+        case RemoteControl::CMD_RECORD:
+        case RemoteControl::CMD_SET_RULE:
+        case RemoteControl::CMD_SET_BRIGHTNESS:
+        case RemoteControl::CMD_SET_SEED:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void RemoteControl::begin(StateManager& sm, OutputManager& om, PowerManager& pm, Recorder& rec, Schedule& sched) {
+    stateManager = &sm;
+    outputManager = &om;
+    powerManager = &pm;
+    recorder = &rec;
+    schedule = &sched;
+}
+
+void RemoteControl::listen() {
+    udp.stop();
+    udp.begin(PORT);
+}
+
+void RemoteControl::poll() {
+    for (int i = 0; i < MAX_PACKETS_PER_POLL; i++) {
+        int length = udp.parsePacket();
+        if (length <= 0) break;
+
+        if (length > MAX_PACKET_SIZE) {
+            udp.flush();  // Too big to be ours
+            rejectedCount++;
+            continue;
+        }
+        int received = udp.read(rxBuffer, length);
+        if (received > 0) handlePacket(received);
+    }
+
+    if (streamIntervalMs > 0) {
+        unsigned long now = millis();
+        if (now - lastStream >= streamIntervalMs) {
+            sendFrame(now);
+        }
+    }
+}
+
+void RemoteControl::handlePacket(size_t length) {
+    if (length < HEADER_SIZE || rxBuffer[0] != MAGIC) {
+        rejectedCount++;
+        return;
+    }
+    packetCount++;
+
+    uint8_t command = rxBuffer[1];
+    const uint8_t* payload = rxBuffer + HEADER_SIZE;
+    size_t payloadLength = length - HEADER_SIZE;
+
+    // Reply header echoes command and sequence for round-trip matching
+    txBuffer[0] = MAGIC;
+    txBuffer[1] = command;
+    txBuffer[2] = rxBuffer[2];
+    txBuffer[3] = rxBuffer[3];
+    uint8_t& status = txBuffer[HEADER_SIZE];
+    size_t replyLength = HEADER_SIZE + 1;
+    status = STATUS_OK;
+
+    switch (command) {
+        case CMD_PING:
+            break;
+
+        case CMD_GET_STATE:
+            replyLength += writeState(txBuffer + replyLength, MAX_PACKET_SIZE - replyLength);
+            break;
+
+        case CMD_SET_OUTPUT:
+        case CMD_SET_PATTERN:
+        case CMD_SET_MODE:
+        case CMD_SET_BRIGHTNESS:
+            status = applyCommand(command, payload, payloadLength);
+            if (status == STATUS_OK) recorder->recordCommand(command, payload, payloadLength);
+            break;
+
+        case CMD_STREAM: {
+            if (payloadLength < 2) {
+                status = STATUS_BAD_REQUEST;
+                break;
+            }
+            uint16_t interval = readU16(payload);
+            if (interval > 0 && interval < MIN_STREAM_INTERVAL_MS) interval = MIN_STREAM_INTERVAL_MS;
+            streamIntervalMs = interval;
+            streamAddress = udp.remoteIP();
+            streamPort = udp.remotePort();
+            break;
+        }
+
+        case CMD_RECORD:
+            if (payloadLength < 1) {
+                status = STATUS_BAD_REQUEST;
+                break;
+            }
+            if (payload[0] & 0x02) recorder->clear();
+            recorder->setEnabled(payload[0] & 0x01);
+            break;
+
+        case CMD_DUMP:
+            if (payloadLength < 2) {
+                status = STATUS_BAD_REQUEST;
+                break;
+            }
+            replyLength += writeRecording(readU16(payload), txBuffer + replyLength, MAX_PACKET_SIZE - replyLength);
+            break;
+
+        case CMD_SET_TIME:
+            if (payloadLength < 4) {
+                status = STATUS_BAD_REQUEST;
+                break;
+            }
+            schedule->setTime(readU32(payload), powerManager->clockMs());
+            break;
+
+        case CMD_SET_RULE: {
+            if (payloadLength < 8 || payload[1] > (uint8_t)ScheduleAction::BRIGHTNESS) {
+                status = STATUS_BAD_REQUEST;
+                break;
+            }
+            ScheduleRule rule = {(ScheduleAction)payload[1], readU16(payload + 2), readU16(payload + 4),
+                                 payload[6], payload[7]};
+            if (!schedule->setRule(payload[0], rule)) status = STATUS_BAD_REQUEST;
+            break;
+        }
+
+        case CMD_SET_SEED:
+            if (payloadLength < 8) {
+                status = STATUS_BAD_REQUEST;
+                break;
+            }
+            stateManager->setRandomSeed(readU32(payload), readU32(payload + 4));
+            recorder->recordSeed(readU32(payload), readU32(payload + 4));
+            break;
+
+        default:
+            status = STATUS_UNKNOWN_COMMAND;
+            break;
+    }
+
+    if (status == STATUS_OK && wakesBadge(command)) powerManager->wake();
+    send(udp.remoteIP(), udp.remotePort(), replyLength);
+}
+
+uint8_t RemoteControl::applyCommand(uint8_t command, const uint8_t* payload, size_t length) {
+    switch (command) {
+        case CMD_SET_OUTPUT:
+            if (length < 5 || payload[0] >= StateManager::MAX_OUTPUTS) return STATUS_BAD_REQUEST;
+            stateManager->setOutput(payload[0], payload[1] & 0x01, payload[2], readU16(payload + 3));
+            stateManager->setColorCycling(payload[0], payload[1] & 0x02);
+            return STATUS_OK;
+
+        case CMD_SET_PATTERN:
+            // Sound patterns are refused unless sound reactive
+            if (length < 1 || !stateManager->setAnimationPattern(payload[0])) return STATUS_BAD_REQUEST;
+            return STATUS_OK;
+
+        case CMD_SET_MODE: {
+            if (length < 1) return STATUS_BAD_REQUEST;
+            bool animating = payload[0] & 0x01;
+            bool soundReactive = payload[0] & 0x02;
+            if (animating != stateManager->isInAnimationMode()) stateManager->toggleAnimationMode();
+            if (soundReactive != stateManager->isSoundReactive()) stateManager->toggleSoundReactive();
+            return STATUS_OK;
+        }
+
+        case CMD_SET_BRIGHTNESS:
+            if (length < 1) return STATUS_BAD_REQUEST;
+            stateManager->setMasterBrightness(payload[0]);
+            return STATUS_OK;
+
+        default:
+            return STATUS_UNKNOWN_COMMAND;
+    }
+}
+
+size_t RemoteControl::writeState(uint8_t* out, size_t capacity) {
+    const size_t perOutput = 4;
+    size_t count = StateManager::MAX_OUTPUTS;
+    if (3 + count * perOutput > capacity) return 0;
+
+    out[0] = (stateManager->isInAnimationMode() ? 0x01 : 0) |
+             (stateManager->isSoundReactive() ? 0x02 : 0);
+    out[1] = stateManager->getAnimationPattern();
+    out[2] = count;
+
+    uint8_t* p = out + 3;
+    for (size_t i = 0; i < count; i++) {
+        OutputState state = stateManager->getUserState(i);
+        p[0] = (state.isOn ? 0x01 : 0) | (state.isColorCycling ? 0x02 : 0);
+        p[1] = state.hue;
+        writeU16(p + 2, state.brightness);
+        p += perOutput;
+    }
+    return p - out;
+}
+
+size_t RemoteControl::writeRecording(uint16_t offset, uint8_t* out, size_t capacity) {
+    writeU16(out, recorder->getSize());
+    return 2 + recorder->read(offset, out + 2, capacity - 2);
+}
+
+void RemoteControl::sendFrame(unsigned long now) {
+    lastStream = now;
+
+    const Frame& frame = outputManager->readFrame();
+    txBuffer[0] = MAGIC;
+    txBuffer[1] = CMD_FRAME;
+    writeU16(txBuffer + 2, streamSequence++);
+    txBuffer[4] = Compositor::NUM_PIXELS;
+
+    uint8_t* p = txBuffer + 5;
+    for (int i = 0; i < Compositor::NUM_PIXELS; i++) {
+        const Rgb16Color& pixel = frame.pixels[i];
+        p[0] = pixel.R >> 8;
+        p[1] = pixel.G >> 8;
+        p[2] = pixel.B >> 8;
+        p += 3;
+    }
+    send(streamAddress, streamPort, p - txBuffer);
+}
+
+void RemoteControl::send(IPAddress address, uint16_t port, size_t length) {
+    udp.beginPacket(address, port);
+    udp.write(txBuffer, length);
+    udp.endPacket();
+}
\ No newline at end of file
@@ -0,0 +1,112 @@
+#ifndef REMOTE_CONTROL_H
+#define REMOTE_CONTROL_H
+
+#include <Arduino.h>
+#include <WiFiUdp.h>
+#include "state_manager.h"
+#include "output_manager.h"
+#include "power_manager.h"
+#include "recorder.h"
+#include "schedule.h"
+
+/*
+Binary UDP control protocol on the soft AP (little endian):
+
+  Request:  'N' | command | seq (u16) | payload...
+  Reply:    'N' | command | seq (u16) | status | payload...
+
+  PING         -                                   -> -
+  GET_STATE    -                                   -> flags, pattern, count, count x (flags, hue, brightness u16)
+  SET_OUTPUT   index, flags, hue, brightness (u16) -> -
+  SET_PATTERN  pattern                             -> -
+  SET_MODE     flags                               -> -
+  STREAM       interval ms (u16), 0 stops          -> -, then FRAME packets to the sender
+  RECORD       flags                               -> -
+  DUMP         offset (u16)                        -> size (u16), recording bytes from offset
+  SET_TIME     seconds since midnight (u32)        -> -
+  SET_RULE     index, action, start min (u16), end min (u16), start level, end level -> -
+  SET_BRIGHTNESS  level (255 = full)               -> -
+  SET_SEED     seed (u32), frame (u32)             -> -
+
+  FRAME        'N' | FRAME | frame seq (u16) | count | count x RGB
+
+Output flags: bit 0 on, bit 1 color cycling. Mode flags: bit 0 party mode,
+bit 1 sound reactive. Record flags: bit 0 recording on, bit 1 clear first
+(turn recording off while dumping so the bytes hold still). Rule actions
+are ScheduleAction values, NONE deletes the rule. Sound patterns are only
+accepted in sound reactive mode. SET_SEED gives the badge a mesh peer's
+pattern seed and frame number, so random patterns sparkle in step. PING,
+GET_STATE, DUMP and SET_TIME are answered without waking an idle badge.
+Everything is parsed in place from fixed buffers.
+*/
+
+class RemoteControl {
+public:
+    static const uint16_t PORT = 4210;
+    static const uint16_t MAX_PACKET_SIZE = 512;
+    static const uint8_t MAX_PACKETS_PER_POLL = 4;  // Bounds the work per scheduler run
+    static const uint16_t MIN_STREAM_INTERVAL_MS = 20;
+    static const uint8_t MAGIC = 'N';
+    static const uint8_t HEADER_SIZE = 4;
+
+    enum Command : uint8_t {
+        CMD_PING = 0x01,
+        CMD_GET_STATE = 0x02,
+        CMD_SET_OUTPUT = 0x03,
+        CMD_SET_PATTERN = 0x04,
+        CMD_SET_MODE = 0x05,
+        CMD_STREAM = 0x06,
+        CMD_RECORD = 0x07,
+        CMD_DUMP = 0x08,
+        CMD_SET_TIME = 0x09,
+        CMD_SET_RULE = 0x0A,
+        CMD_SET_BRIGHTNESS = 0x0B,
+        CMD_SET_SEED = 0x0C,
+        CMD_FRAME = 0x80
+    };
+
+    enum Status : uint8_t {
+        STATUS_OK = 0,
+        STATUS_BAD_REQUEST = 1,
+        STATUS_UNKNOWN_COMMAND = 2
+    };
+
+    void begin(StateManager& stateManager, OutputManager& outputManager, PowerManager& powerManager,
+               Recorder& recorder, Schedule& schedule);
+    void listen();  // (Re)bind the socket, call whenever the AP comes up
+    void poll();    // Run from the scheduler's network task
+
+    // Commands that change state, shared with the replayer
+    uint8_t applyCommand(uint8_t command, const uint8_t* payload, size_t length);
+
+    uint32_t getPacketCount() const { return packetCount; }
+    uint32_t getRejectedCount() const { return rejectedCount; }
+
+private:
+    StateManager* stateManager = nullptr;
+    OutputManager* outputManager = nullptr;
+    PowerManager* powerManager = nullptr;
+    Recorder* recorder = nullptr;
+    Schedule* schedule = nullptr;
+    WiFiUDP udp;
+
+    uint8_t rxBuffer[MAX_PACKET_SIZE];
+    uint8_t txBuffer[MAX_PACKET_SIZE];
+
+    IPAddress streamAddress;
+    uint16_t streamPort = 0;
+    uint16_t streamIntervalMs = 0;
+    uint16_t streamSequence = 0;
+    unsigned long lastStream = 0;
+
+    uint32_t packetCount = 0;
+    uint32_t rejectedCount = 0;
+
+    void handlePacket(size_t length);
+    size_t writeState(uint8_t* out, size_t capacity);
+    size_t writeRecording(uint16_t offset, uint8_t* out, size_t capacity);
+    void sendFrame(unsigned long now);
+    void send(IPAddress address, uint16_t port, size_t length);
+};
+
+#endif
\ No newline at end of file
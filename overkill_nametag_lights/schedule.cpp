@@ -0,0 +1,114 @@
+#include "schedule.h"
+
+static const ScheduleState UNSCHEDULED = {false, false, 255};
+
+Schedule::Schedule() {
+    clearRules();
+    rules[0] = {ScheduleAction::BLACKOUT, 23 * 60, 7 * 60, 0, 0};
+}
+
+void Schedule::setTime(uint32_t secondOfDay, unsigned long now) {
+    baseSecond = secondOfDay % SECONDS_PER_DAY;
+    clockSetAt = now;
+    clockSet = true;
+}
+
+uint32_t Schedule::getSecondOfDay(unsigned long now) const {
+    // Good for the 49 days until millis() wraps; phones and mesh peers set
+    // the clock again long before that
+    uint32_t elapsed = (now - clockSetAt) / 1000;
+    return (baseSecond + elapsed % SECONDS_PER_DAY) % SECONDS_PER_DAY;
+}
+
+bool Schedule::setRule(uint8_t index, const ScheduleRule& rule) {
+    if (index >= MAX_RULES || rule.startMinute >= MINUTES_PER_DAY || rule.endMinute >= MINUTES_PER_DAY) {
+        return false;
+    }
+    rules[index] = rule;
+    return true;
+}
+
+void Schedule::clearRules() {
+    for (int i = 0; i < MAX_RULES; i++) {
+        rules[i] = {ScheduleAction::NONE, 0, 0, 0, 0};
+    }
+}
+
+ScheduleState Schedule::evaluate(unsigned long now) const {
+    if (!clockSet) return UNSCHEDULED;
+    return evaluateAt(getSecondOfDay(now));
+}
+
+uint32_t Schedule::secondsUntilChange(unsigned long now) const {
+    if (!clockSet) return SECONDS_PER_DAY;
+    return secondsUntilChangeAt(getSecondOfDay(now));
+}
+
+ScheduleState Schedule::evaluateAt(uint32_t secondOfDay) const {
+    ScheduleState state = UNSCHEDULED;
+    for (int i = 0; i < MAX_RULES; i++) {
+        const ScheduleRule& rule = rules[i];
+        if (rule.action == ScheduleAction::NONE) continue;
+        int32_t offset = windowOffset(rule, secondOfDay);
+        if (offset < 0) continue;
+
+        switch (rule.action) {
+            case ScheduleAction::BLACKOUT:
+                state.blackout = true;
+                break;
+
+            case ScheduleAction::PARTY:
+                state.party = true;
+                break;
+
+            case ScheduleAction::BRIGHTNESS: {
+                // Overlapping curves multiply. Steps of RAMP_STEP_S keep
+                // the badge from waking for every level.
+                int32_t span = (int32_t)rule.endLevel - rule.startLevel;
+                offset -= offset % RAMP_STEP_S;
+                uint8_t level = rule.startLevel + span * offset / (int32_t)windowLength(rule);
+                state.brightness = ((uint16_t)state.brightness * (level + (level >> 7))) >> 8;
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+    if (state.blackout) state.brightness = 0;
+    return state;
+}
+
+uint32_t Schedule::secondsUntilChangeAt(uint32_t secondOfDay) const {
+    uint32_t next = SECONDS_PER_DAY;
+    for (int i = 0; i < MAX_RULES; i++) {
+        const ScheduleRule& rule = rules[i];
+        if (rule.action == ScheduleAction::NONE) continue;
+
+        // Nearest window edge ahead of us
+        uint32_t edges[2] = {(uint32_t)rule.startMinute * 60, (uint32_t)rule.endMinute * 60};
+        for (uint32_t edge : edges) {
+            uint32_t until = (edge + SECONDS_PER_DAY - secondOfDay) % SECONDS_PER_DAY;
+            if (until > 0 && until < next) next = until;
+        }
+
+        // Ramps step all through the window
+        int32_t offset = windowOffset(rule, secondOfDay);
+        if (rule.action == ScheduleAction::BRIGHTNESS && rule.startLevel != rule.endLevel && offset >= 0) {
+            uint32_t untilStep = RAMP_STEP_S - offset % RAMP_STEP_S;
+            if (untilStep < next) next = untilStep;
+        }
+    }
+    return next;
+}
+
+int32_t Schedule::windowOffset(const ScheduleRule& rule, uint32_t secondOfDay) {
+    uint32_t start = (uint32_t)rule.startMinute * 60;
+    uint32_t offset = (secondOfDay + SECONDS_PER_DAY - start) % SECONDS_PER_DAY;
+    return offset < windowLength(rule) ? (int32_t)offset : -1;
+}
+
+uint32_t Schedule::windowLength(const ScheduleRule& rule) {
+    uint32_t minutes = (rule.endMinute + MINUTES_PER_DAY - rule.startMinute) % MINUTES_PER_DAY;
+    return minutes * 60;
+}
\ No newline at end of file
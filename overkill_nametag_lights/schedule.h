@@ -0,0 +1,71 @@
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include <Arduino.h>
+
+enum class ScheduleAction : uint8_t {
+    NONE,
+    BLACKOUT,       // LEDs off, badge sleeps through the window
+    PARTY,          // Party mode on for the window
+    BRIGHTNESS      // Brightness ramps from startLevel to endLevel across the window
+};
+
+// A daily window, start inclusive and end exclusive, in minutes after
+// midnight. A window that ends before it starts runs over midnight.
+struct ScheduleRule {
+    ScheduleAction action;
+    uint16_t startMinute;
+    uint16_t endMinute;
+    uint8_t startLevel;     // Brightness rules only
+    uint8_t endLevel;
+};
+
+// What the rules ask for at one moment
+struct ScheduleState {
+    bool blackout;
+    bool party;
+    uint8_t brightness;     // 255 = full
+};
+
+// Time-of-day rules for unattended badges. The clock is the
+// PowerManager::clockMs() offset from the last setTime(), which a phone
+// (remote control) or a mesh peer provides; with no clock set, nothing is
+// scheduled.
+class Schedule {
+public:
+    static const uint8_t MAX_RULES = 8;
+    static const uint16_t MINUTES_PER_DAY = 24 * 60;
+    static const uint32_t SECONDS_PER_DAY = 24UL * 60 * 60;
+    static const uint16_t RAMP_STEP_S = 60;     // Brightness ramps step this often
+
+    Schedule();     // Blacks out 23:00-07:00 once the clock is set
+
+    // Clock
+    void setTime(uint32_t secondOfDay, unsigned long now);
+    bool isClockSet() const { return clockSet; }
+    uint32_t getSecondOfDay(unsigned long now) const;
+
+    // Rules
+    bool setRule(uint8_t index, const ScheduleRule& rule);
+    const ScheduleRule& getRule(uint8_t index) const { return rules[index]; }
+    void clearRules();
+
+    ScheduleState evaluate(unsigned long now) const;
+    uint32_t secondsUntilChange(unsigned long now) const;   // evaluate() holds until then
+
+    // The same, at a given time of day
+    ScheduleState evaluateAt(uint32_t secondOfDay) const;
+    uint32_t secondsUntilChangeAt(uint32_t secondOfDay) const;
+
+private:
+    ScheduleRule rules[MAX_RULES];
+    bool clockSet = false;
+    uint32_t baseSecond = 0;        // Time of day at clockSetAt
+    unsigned long clockSetAt = 0;
+
+    // Seconds into the rule's window, or -1 when outside it
+    static int32_t windowOffset(const ScheduleRule& rule, uint32_t secondOfDay);
+    static uint32_t windowLength(const ScheduleRule& rule);
+};
+
+#endif
\ No newline at end of file
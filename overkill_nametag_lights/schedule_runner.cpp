@@ -0,0 +1,71 @@
+#include "schedule_runner.h"
+
+void ScheduleRunner::begin(Schedule& sched, StateManager& sm, PowerManager& pm, RemoteControl& rc,
+                           Recorder& rec) {
+    schedule = &sched;
+    stateManager = &sm;
+    powerManager = &pm;
+    remoteControl = &rc;
+    recorder = &rec;
+}
+
+void ScheduleRunner::update() {
+    unsigned long now = powerManager->clockMs();
+    ScheduleState target = schedule->evaluate(now);
+    if (target.party && !scheduledParty) {
+        if (!stateManager->isInAnimationMode()) setParty(true);
+        scheduledParty = true;
+    } else if (!target.party && scheduledParty) {
+        if (stateManager->isInAnimationMode()) setParty(false);
+        scheduledParty = false;
+    }
+
+    if (!target.blackout) {
+        if (powerManager->isInBlackout()) powerManager->endBlackout();
+        overriding = false;
+        wasBlackout = false;
+        followBrightness(target.brightness);
+        return;
+    }
+
+    if (wasBlackout && !powerManager->isInBlackout() && !overriding) {
+        overriding = true;  // Woken by a press
+        overrideSince = now;
+        setBrightness(255);
+    }
+    if (overriding && now - overrideSince < BLACKOUT_OVERRIDE_MS) return;
+    if (overriding) {
+        overriding = false;
+        wasBlackout = false;    // Going dark again is not another press
+    }
+
+    // Render one dark frame before the render tasks stop
+    if (stateManager->getMasterBrightness() > 0) {
+        setBrightness(0);
+        return;
+    }
+    wasBlackout = true;
+    powerManager->beginBlackout(schedule->secondsUntilChange(now) * 1000UL);
+}
+
+void ScheduleRunner::applyCommand(uint8_t command, uint8_t value) {
+    if (remoteControl->applyCommand(command, &value, 1) != RemoteControl::STATUS_OK) return;
+    recorder->recordCommand(command, &value, 1);
+    powerManager->wake();
+}
+
+void ScheduleRunner::followBrightness(uint8_t level) {
+    if (scheduledBrightness == level) return;
+    setBrightness(level);
+}
+
+void ScheduleRunner::setBrightness(uint8_t level) {
+    scheduledBrightness = level;
+    if (stateManager->getMasterBrightness() == level) return;
+    applyCommand(RemoteControl::CMD_SET_BRIGHTNESS, level);
+}
+
+void ScheduleRunner::setParty(bool party) {
+    uint8_t flags = (party ? 0x01 : 0) | (stateManager->isSoundReactive() ? 0x02 : 0);
+    applyCommand(RemoteControl::CMD_SET_MODE, flags);
+}
\ No newline at end of file
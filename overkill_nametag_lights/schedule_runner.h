@@ -0,0 +1,46 @@
+#ifndef SCHEDULE_RUNNER_H
+#define SCHEDULE_RUNNER_H
+
+#include <Arduino.h>
+#include "schedule.h"
+#include "state_manager.h"
+#include "power_manager.h"
+#include "remote_control.h"
+#include "recorder.h"
+
+// Follows the time-of-day schedule: brightness curves, party hours and
+// blackouts. The schedule only acts when what it asks for changes, so a
+// phone's brightness or mode holds until the next scheduled transition. A
+// button press during a blackout lights the badge up for a while before it
+// goes back to sleep.
+//
+// Changes take the same path as remote commands, so replays see them and
+// idle render tasks wake up to show them.
+class ScheduleRunner {
+public:
+    static const unsigned long BLACKOUT_OVERRIDE_MS = 5 * 60 * 1000UL;
+
+    void begin(Schedule& schedule, StateManager& stateManager, PowerManager& powerManager,
+               RemoteControl& remoteControl, Recorder& recorder);
+    void update();  // Run from the schedule task, not while replaying
+
+private:
+    Schedule* schedule = nullptr;
+    StateManager* stateManager = nullptr;
+    PowerManager* powerManager = nullptr;
+    RemoteControl* remoteControl = nullptr;
+    Recorder* recorder = nullptr;
+
+    bool scheduledParty = false;        // Party mode was switched on by the schedule
+    int16_t scheduledBrightness = -1;   // Last level the schedule asked for, -1 for none yet
+    bool wasBlackout = false;
+    bool overriding = false;
+    unsigned long overrideSince = 0;
+
+    void applyCommand(uint8_t command, uint8_t value);
+    void followBrightness(uint8_t level);   // Only when the schedule's level changes
+    void setBrightness(uint8_t level);
+    void setParty(bool party);
+};
+
+#endif
\ No newline at end of file
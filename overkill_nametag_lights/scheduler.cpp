@@ -0,0 +1,197 @@
+#include "scheduler.h"
+#include <limits.h>
+
+int Scheduler::addPeriodic(const char* name, TaskFunction run, TaskPriority priority,
+                           unsigned long periodMs, unsigned long budgetUs) {
+    return addTask(name, run, priority, periodMs * 1000UL, budgetUs);
+}
+
+int Scheduler::addEvent(const char* name, TaskFunction run, TaskPriority priority,
+                        unsigned long budgetUs) {
+    return addTask(name, run, priority, 0, budgetUs);
+}
+
+int Scheduler::addTask(const char* name, TaskFunction run, TaskPriority priority,
+                       unsigned long periodUs, unsigned long budgetUs) {
+    if (taskCount >= MAX_TASKS) return -1;
+
+    Task& task = tasks[taskCount];
+    task.name = name;
+    task.run = run;
+    task.priority = priority;
+    task.periodUs = periodUs;
+    task.budgetUs = budgetUs;
+    task.nextRunUs = micros();
+    task.pending = false;
+    task.enabled = true;
+    task.runs = 0;
+    task.overruns = 0;
+    task.lateRuns = 0;
+    task.deferrals = 0;
+    task.maxRunUs = 0;
+
+    return taskCount++;
+}
+
+void Scheduler::setPeriod(int id, unsigned long periodMs) {
+    setPeriodUs(id, periodMs * 1000UL);
+}
+
+void Scheduler::setPeriodUs(int id, unsigned long periodUs) {
+    if (id < 0 || id >= taskCount) return;
+    tasks[id].periodUs = periodUs;
+}
+
+void Scheduler::setEnabled(int id, bool enabled) {
+    if (id < 0 || id >= taskCount) return;
+    if (enabled && !tasks[id].enabled) {
+        tasks[id].nextRunUs = micros();
+        deferred[id] = false;
+    }
+    tasks[id].enabled = enabled;
+}
+
+void Scheduler::trigger(int id) {
+    if (id < 0 || id >= taskCount) return;
+    tasks[id].pending = true;
+}
+
+void Scheduler::skipAhead(unsigned long us) {
+    // Pull deadlines in, but no further than now: the time was slept, not
+    // spent running late
+    unsigned long now = micros();
+    for (int i = 0; i < taskCount; i++) {
+        Task& task = tasks[i];
+        long remaining = (long)(task.nextRunUs - now);
+        if (remaining <= 0) continue;
+        task.nextRunUs = (unsigned long)remaining > us ? task.nextRunUs - us : now;
+    }
+}
+
+bool Scheduler::isDue(const Task& task, unsigned long now) const {
+    if (!task.enabled) return false;
+    if (task.pending) return true;
+    if (task.periodUs == 0) return false;
+    return (long)(now - task.nextRunUs) >= 0;
+}
+
+int Scheduler::pickDue(unsigned long now, const bool* passed) const {
+    int selected = -1;
+    for (int i = 0; i < taskCount; i++) {
+        const Task& task = tasks[i];
+        if (passed[i] || !isDue(task, now)) continue;
+        if (selected < 0 || task.priority < tasks[selected].priority ||
+            (task.priority == tasks[selected].priority &&
+             (long)(task.nextRunUs - tasks[selected].nextRunUs) < 0)) {
+            selected = i;
+        }
+    }
+    return selected;
+}
+
+long Scheduler::timeToNextRender(unsigned long now) const {
+    long earliest = LONG_MAX;
+    for (int i = 0; i < taskCount; i++) {
+        const Task& task = tasks[i];
+        if (task.priority != PRIORITY_RENDER || task.periodUs == 0 || !task.enabled) continue;
+        long remaining = (long)(task.nextRunUs - now);
+        if (remaining < earliest) earliest = remaining;
+    }
+    return earliest;
+}
+
+bool Scheduler::holdBack(int id, long untilRender) {
+    Task& task = tasks[id];
+    if (task.priority == PRIORITY_RENDER || (long)task.budgetUs <= untilRender) return false;
+    if (!deferred[id]) {
+        deferred[id] = true;
+        deferredAtRender[id] = renderCount;
+        task.deferrals++;
+        return true;
+    }
+    return deferredAtRender[id] == renderCount;
+}
+
+void Scheduler::runOnce() {
+    unsigned long now = micros();
+    long untilRender = timeToNextRender(now);
+
+    // Pick the highest priority due task, earliest deadline breaking ties.
+    // If it would run into the next frame it is held back, unless a render
+    // has already gone by while it waited, and the next best gets a go.
+    // Tasks that lose on priority aren't held back, just not picked.
+    bool passed[MAX_TASKS] = {};
+    int selected;
+    while (true) {
+        selected = pickDue(now, passed);
+        if (selected < 0) return;
+        if (!holdBack(selected, untilRender)) break;
+        passed[selected] = true;
+    }
+
+    Task& task = tasks[selected];
+    deferred[selected] = false;
+    if (task.priority == PRIORITY_RENDER) renderCount++;
+
+    if (task.periodUs > 0 && (long)(now - task.nextRunUs) >= (long)task.periodUs) {
+        task.lateRuns++;
+    }
+
+    task.pending = false;
+    unsigned long start = micros();
+    task.run();
+    unsigned long elapsed = micros() - start;
+
+    task.runs++;
+    if (elapsed > task.maxRunUs) task.maxRunUs = elapsed;
+    if (elapsed > task.budgetUs) task.overruns++;
+
+    if (task.periodUs > 0) {
+        task.nextRunUs += task.periodUs;
+        // Fell behind by more than a period: resync instead of bursting
+        if ((long)(start - task.nextRunUs) >= 0) {
+            task.nextRunUs = start + task.periodUs;
+        }
+    }
+}
+
+unsigned long Scheduler::getIdleTimeUs() const {
+    unsigned long now = micros();
+    long untilRender = timeToNextRender(now);
+    long earliest = LONG_MAX;
+    for (int i = 0; i < taskCount; i++) {
+        const Task& task = tasks[i];
+        if (!task.enabled) continue;
+        if (deferred[i] && deferredAtRender[i] == renderCount) {
+            // Held back: nothing to do for it before the render
+            if (untilRender < earliest) earliest = untilRender;
+            continue;
+        }
+        if (task.pending) return 0;
+        if (task.periodUs == 0) continue;
+        long remaining = (long)(task.nextRunUs - now);
+        if (remaining < earliest) earliest = remaining;
+    }
+    return earliest < 0 ? 0 : earliest;
+}
+
+void Scheduler::printStats(Print& out) const {
+    out.printf("%-10s %4s %8s %8s %6s %6s %6s\n",
+               "task", "prio", "runs", "max_us", "over", "late", "defer");
+    for (int i = 0; i < taskCount; i++) {
+        const Task& task = tasks[i];
+        out.printf("%-10s %4u %8u %8lu %6u %6u %6u\n",
+                   task.name, (unsigned)task.priority, (unsigned)task.runs, task.maxRunUs,
+                   (unsigned)task.overruns, (unsigned)task.lateRuns, (unsigned)task.deferrals);
+    }
+}
+
+void Scheduler::resetStats() {
+    for (int i = 0; i < taskCount; i++) {
+        tasks[i].runs = 0;
+        tasks[i].overruns = 0;
+        tasks[i].lateRuns = 0;
+        tasks[i].deferrals = 0;
+        tasks[i].maxRunUs = 0;
+    }
+}
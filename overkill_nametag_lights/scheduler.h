@@ -0,0 +1,78 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+
+// Lower value runs first
+enum TaskPriority : uint8_t {
+    PRIORITY_RENDER = 0,
+    PRIORITY_INPUT,
+    PRIORITY_NETWORK,
+    PRIORITY_HOUSEKEEPING
+};
+
+using TaskFunction = void (*)();
+
+struct Task {
+    const char* name;
+    TaskFunction run;
+    TaskPriority priority;
+    unsigned long periodUs;     // 0 for event-triggered tasks
+    unsigned long budgetUs;     // Expected worst case run time
+    unsigned long nextRunUs;
+    volatile bool pending;      // Set by trigger(), safe from an ISR
+    bool enabled;               // Suspended tasks are never due
+
+    // Accounting
+    uint32_t runs;
+    uint32_t overruns;          // Runs that took longer than budgetUs
+    uint32_t lateRuns;          // Periodic runs that started a full period late
+    uint32_t deferrals;         // Times held back to protect a render deadline
+    unsigned long maxRunUs;
+};
+
+// Cooperative scheduler. Each runOnce() runs at most one task: the highest
+// priority task that is due. Lower priority tasks are held back while their
+// budget would run past the next render deadline, so a busy network or OTA
+// task cannot make a frame late. A held back task waits for one render at
+// most, then runs whatever the next deadline.
+class Scheduler {
+public:
+    static const uint8_t MAX_TASKS = 10;
+
+    int addPeriodic(const char* name, TaskFunction run, TaskPriority priority,
+                    unsigned long periodMs, unsigned long budgetUs);
+    int addEvent(const char* name, TaskFunction run, TaskPriority priority,
+                 unsigned long budgetUs);
+    void setPeriod(int id, unsigned long periodMs);
+    void setPeriodUs(int id, unsigned long periodUs);   // Sub-millisecond tasks (audio capture)
+    void setEnabled(int id, bool enabled);  // Re-enabled tasks are due immediately
+    void trigger(int id);
+    void skipAhead(unsigned long us);   // Time micros() missed (forced light sleep) went by
+
+    void runOnce();
+
+    // Time until the next task is due, for idle sleeping
+    unsigned long getIdleTimeUs() const;
+
+    int getTaskCount() const { return taskCount; }
+    const Task& getTask(int id) const { return tasks[id]; }
+    void printStats(Print& out) const;
+    void resetStats();
+
+private:
+    Task tasks[MAX_TASKS];
+    uint8_t taskCount = 0;
+    uint32_t renderCount = 0;                   // Render task runs, for deferral
+    bool deferred[MAX_TASKS] = {};
+    uint32_t deferredAtRender[MAX_TASKS] = {};  // renderCount when first held back
+
+    int addTask(const char* name, TaskFunction run, TaskPriority priority,
+                unsigned long periodUs, unsigned long budgetUs);
+    bool isDue(const Task& task, unsigned long now) const;
+    int pickDue(unsigned long now, const bool* passed) const;  // Best due task not passed over, or -1
+    bool holdBack(int id, long untilRender);
+    long timeToNextRender(unsigned long now) const;
+};
+
+#endif
@@ -11,13 +11,14 @@ void ShiftRegisterController::begin() {
 
 void ShiftRegisterController::updateRegister(int index, bool state) {
     if (index >= NUM_OUTPUTS) return;
-    shiftStates[index] = state;
+    if (state) shiftStates[index >> 3] |= (1 << (index & 7));
+    else shiftStates[index >> 3] &= ~(1 << (index & 7));
 }
 
 void ShiftRegisterController::updateAll() {
     shiftRegister.batchWriteBegin();
     for (int i = 0; i < NUM_OUTPUTS; i++) {
-        shiftRegister.writeBit(i, shiftStates[i]);
+        shiftRegister.writeBit(i, (shiftStates[i >> 3] >> (i & 7)) & 1);
     }
     shiftRegister.batchWriteEnd();
 }
\ No newline at end of file
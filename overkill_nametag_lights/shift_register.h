@@ -2,10 +2,14 @@
 #define SHIFTREGISTER_H
 
 #include <Shifty.h>
+#include "config.h"
 
+// Daisy-chained 74HC595s driving the status LEDs. Bit 0 is unused, so
+// output i is bit i + 1 and the chain is rounded up to whole registers.
 class ShiftRegisterController {
 public:
-    static const int NUM_OUTPUTS = 8;
+    static const int NUM_OUTPUTS = ((NAMETAG_NUM_OUTPUTS + 1 + 7) / 8) * 8;
+    static const int NUM_REGISTERS = NUM_OUTPUTS / 8;
     static const int SHIFT_DATA_PIN = 16;
     static const int SHIFT_CLOCK_PIN = 15;
 
@@ -16,7 +20,7 @@ public:
 
 private:
     Shifty shiftRegister;
-    bool shiftStates[NUM_OUTPUTS];
+    uint8_t shiftStates[NUM_REGISTERS];   // Packed, one bit per output
 };
 
 #endif
\ No newline at end of file
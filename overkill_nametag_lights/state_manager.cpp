@@ -3,113 +3,222 @@
 
 StateManager::StateManager() {
     for (int i = 0; i < MAX_OUTPUTS; i++) {
-        outputs[i] = {false, 0, 255, false, 0};  // Default to full brightness
+        outputs.reset(i, MAX_BRIGHTNESS);  // Default to full brightness
+        animOutputs.reset(i, MAX_BRIGHTNESS);
     }
 }
 
 void StateManager::toggleOutput(int index) {
     if (index >= MAX_OUTPUTS) return;
-    outputs[index].isOn = !outputs[index].isOn;
+    OutputBank::setBit(outputs.on, index, !OutputBank::getBit(outputs.on, index));
+    // For future networking: stateChanged = true;
+}
+
+void StateManager::setOutput(int index, bool isOn, uint8_t hue, uint16_t brightness) {
+    if (index >= MAX_OUTPUTS) return;
+    OutputBank::setBit(outputs.on, index, isOn);
+    outputs.hue[index] = hue;
+    outputs.brightness[index] = brightness;
     // For future networking: stateChanged = true;
 }
 
 void StateManager::setColorCycling(int index, bool enabled) {
     if (index >= MAX_OUTPUTS) return;
-    outputs[index].isColorCycling = enabled;
+    OutputBank::setBit(outputs.cycling, index, enabled);
     // For future networking: stateChanged = true;
 }
 
 void StateManager::updateHue(int index) {
     if (index >= MAX_OUTPUTS) return;
-    if (outputs[index].isColorCycling) {
-        outputs[index].hue += 2;
+    if (OutputBank::getBit(outputs.cycling, index)) {
+        outputs.hue[index] += 2;
         // For future networking: stateChanged = true;
     }
 }
 
 void StateManager::update() {
-    static unsigned long lastUpdate = 0;
-    const unsigned long UPDATE_INTERVAL = 20;  // Same as original delay
-    unsigned long currentMillis = millis();
-
-    if (currentMillis - lastUpdate < UPDATE_INTERVAL) {
-        return;  // Not time to update yet
-    }
-
-    lastUpdate = currentMillis;
-
     // Handle animation mode updates
     if (animState.isAnimating) {
         updateAnimations();
         return;  // Skip individual updates in animation mode
     }
     
-    // Handle individual LED updates (color cycling)
-    for (int i = 0; i < MAX_OUTPUTS; i++) {
-        if (outputs[i].isColorCycling && outputs[i].isOn) {
-            updateHue(i);
+    // Handle individual LED updates (color cycling), a word of outputs at a time
+    for (int w = 0; w < OutputBank::WORDS; w++) {
+        uint32_t active = outputs.cycling[w] & outputs.on[w];
+        while (active) {
+            int bit = __builtin_ctz(active);
+            active &= active - 1;
+            outputs.hue[w * 32 + bit] += 2;
         }
     }
 }
 
-const OutputState& StateManager::getState(int index) const {
-    static OutputState defaultState = {false, 0, false};
-    if (index >= MAX_OUTPUTS) return defaultState;
-    return outputs[index];
+OutputState StateManager::getState(int index) const {
+    return animState.isAnimating ? getAnimationState(index) : getUserState(index);
+}
+
+OutputState StateManager::getUserState(int index) const {
+    if (index >= MAX_OUTPUTS) return {false, 0, 0, false, 0};
+    return outputs.get(index);
+}
+
+OutputState StateManager::getAnimationState(int index) const {
+    if (index >= MAX_OUTPUTS) return {false, 0, 0, false, 0};
+    return animOutputs.get(index);
 }
 
 bool StateManager::isActive(int index) const {
     if (index >= MAX_OUTPUTS) return false;
-    return outputs[index].isOn;
+    return OutputBank::getBit(outputs.on, index);
+}
+
+void StateManager::handleButtonEvent(const ButtonEventData& event) {
+    switch(event.type) {
+        case ButtonEvent::CLICKED:
+            if (!isInAnimationMode()) {
+                toggleOutput(event.buttonIndex);
+            } else if (isSoundReactive()) {
+                setAnimationPattern(NUM_BASE_PATTERNS + event.buttonIndex);
+            } else {
+                setAnimationPattern(event.buttonIndex);
+            }
+            break;
+            
+        case ButtonEvent::DOUBLE_CLICKED:
+            toggleAnimationMode();
+            break;
+            
+        case ButtonEvent::LONG_PRESSED:
+            if (!isInAnimationMode()) {
+                setColorCycling(event.buttonIndex, true);
+            } else {
+                // Nothing shows the mode until music plays: green on, red off
+                toggleSoundReactive();
+                if (isSoundReactive()) notify(NOTIFY_ON_HUE);
+                else notify(NOTIFY_OFF_HUE);
+            }
+            break;
+            
+        case ButtonEvent::LONG_PRESS_RELEASED:
+            if (!isInAnimationMode()) {
+                setColorCycling(event.buttonIndex, false);
+            }
+            break;
+    }
 }
 
 void StateManager::resetOutput(int index) {
     if (index >= MAX_OUTPUTS) return;
-    outputs[index] = {false, 0, 255, false, 0};  // Reset to default state
+    outputs.reset(index, MAX_BRIGHTNESS);  // Reset to default state
     // For future networking: stateChanged = true;
 }
 
 void StateManager::toggleAnimationMode() {
     animState.isAnimating = !animState.isAnimating;
     if (animState.isAnimating) {
-        // Reset all outputs for animation mode
+        // Animation runs on its own layer; the user's colors are left alone
+        // and come back when party mode ends
+        memset(outputs.cycling, 0, sizeof(outputs.cycling));
+        animOutputs.setAllOn();
         for (int i = 0; i < MAX_OUTPUTS; i++) {
-            outputs[i].isOn = true;
-            outputs[i].isColorCycling = false;
-            outputs[i].brightness = 255;
+            animOutputs.brightness[i] = MAX_BRIGHTNESS;
             // Space the LEDs evenly around the color wheel
-            outputs[i].animationOffset = (i * 256) / MAX_OUTPUTS;
-        }
-    } else {
-        // Reset all outputs to off when exiting animation mode
-        for (int i = 0; i < MAX_OUTPUTS; i++) {
-            resetOutput(i);
+            animOutputs.animationOffset[i] = (i * 256) / MAX_OUTPUTS;
         }
     }
 }
 
-void StateManager::setAnimationPattern(uint8_t pattern) {
-    if (pattern < NUM_PATTERNS) {
-        animState.pattern = pattern;
-        Serial.print("Animation: ");
-        switch (animState.pattern) {
-            case 0: Serial.println("0 - Rainbow"); break;
-            case 1: Serial.println("1 - Wave"); break;
-            case 2: Serial.println("2 - Pulse"); break;
-            case 3: Serial.println("3 - Sparkle"); break;
-            case 4: Serial.println("4 - Chase"); break;
-            case 5: Serial.println("5 - Breathing"); break;
-        }
+bool StateManager::setAnimationPattern(uint8_t pattern) {
+    // Sound patterns only while sound reactive, whichever button or command
+    // asks: a chain can have more buttons than there are regular patterns
+    int available = NUM_BASE_PATTERNS;
+    if (animState.soundReactive) available = NUM_PATTERNS;
+    if (pattern >= available) return false;
+
+    animState.pattern = pattern;
+    Serial.print("Animation: ");
+    switch (animState.pattern) {
+        case 0: Serial.println("0 - Rainbow"); break;
+        case 1: Serial.println("1 - Wave"); break;
+        case 2: Serial.println("2 - Pulse"); break;
+        case 3: Serial.println("3 - Sparkle"); break;
+        case 4: Serial.println("4 - Chase"); break;
+        case 5: Serial.println("5 - Breathing"); break;
+        case 6: Serial.println("6 - Spectrum"); break;
+        case 7: Serial.println("7 - Beat Flash"); break;
+        case 8: Serial.println("8 - Level Meter"); break;
     }
+    return true;
+}
+
+void StateManager::notify(uint8_t hue) {
+    animState.notifyHue = hue;
+    animState.notifyCount++;
 }
 
 uint8_t StateManager::getAnimationPattern() {
     return animState.pattern;
 }
 
+void StateManager::toggleSoundReactive() {
+    animState.soundReactive = !animState.soundReactive;
+    if (!animState.soundReactive) {
+        animState.speed = BASE_SPEED;
+        if (animState.pattern >= NUM_BASE_PATTERNS) {
+            setAnimationPattern(0);  // Sound patterns are meaningless without sound
+        }
+    }
+}
+
+void StateManager::setAudioFeatures(const AudioFeatures& features) {
+    audio = features;
+    pendingBeat |= features.beat;
+    if (animState.soundReactive) {
+        // Louder music runs the regular patterns faster
+        animState.speed = BASE_SPEED + (features.level >> 6);
+    }
+}
+
+void StateManager::setRandomSeed(uint32_t seed, uint32_t frame) {
+    patternSeed = seed;
+    frameCount = frame;
+}
+
+void StateManager::saveSnapshot(StateSnapshot& snapshot) const {
+    snapshot.outputs = outputs;
+    snapshot.animOutputs = animOutputs;
+    snapshot.animState = animState;
+    snapshot.patterns = patterns;
+    snapshot.patternSeed = patternSeed;
+    snapshot.frameCount = frameCount;
+    snapshot.audio = audio;
+    snapshot.pendingBeat = pendingBeat;
+    snapshot.masterBrightness = masterBrightness;
+}
+
+void StateManager::restoreSnapshot(const StateSnapshot& snapshot) {
+    outputs = snapshot.outputs;
+    animOutputs = snapshot.animOutputs;
+    animState = snapshot.animState;
+    patterns = snapshot.patterns;
+    patternSeed = snapshot.patternSeed;
+    frameCount = snapshot.frameCount;
+    audio = snapshot.audio;
+    pendingBeat = snapshot.pendingBeat;
+    masterBrightness = snapshot.masterBrightness;
+}
+
+void StateManager::publish(StateBuffer& buffer) const {
+    saveSnapshot(buffer.writeBuffer());
+    buffer.publish();
+}
+
 void StateManager::updateAnimations() {
     if (!animState.isAnimating) return;
     
+    rng.setSeed(Prng::seedForFrame(patternSeed, frameCount++));
+    
     switch (animState.pattern) {
         case 0: updateRainbow(); break;
         case 1: updateWave(); break;
@@ -117,28 +226,30 @@ void StateManager::updateAnimations() {
         case 3: updateSparkle(); break;
         case 4: updateChase(); break;
         case 5: updateBreathing(); break;
+        case 6: updateSpectrum(); break;
+        case 7: updateBeatFlash(); break;
+        case 8: updateLevelMeter(); break;
     }
 }
 
 // Animation pattern implementations
 void StateManager::updateRainbow() {
-    static float offset = 0;
+    float& offset = patterns.rainbowOffset;
     const float RAINBOW_SPEED = 0.1f;
     
     offset = fmod(offset + RAINBOW_SPEED * animState.speed, 256);
     
     for (int i = 0; i < MAX_OUTPUTS; i++) {
-        outputs[i].isOn = true;
-        outputs[i].brightness = 255;
-        outputs[i].hue = (uint8_t)(offset + (i * 256.0f / MAX_OUTPUTS));
+        animOutputs.brightness[i] = MAX_BRIGHTNESS;
+        animOutputs.hue[i] = (uint8_t)(offset + (i * 256.0f / MAX_OUTPUTS));
     }
 }
 
 void StateManager::updateWave() {
-    static float wavePosition = 0;
-    static float lastWavePosition = 0;
-    static uint8_t targetHues[MAX_OUTPUTS];
-    static bool huesInitialized = false;
+    float& wavePosition = patterns.wavePosition;
+    float& lastWavePosition = patterns.lastWavePosition;
+    uint8_t (&targetHues)[MAX_OUTPUTS] = patterns.waveTargetHues;
+    bool& huesInitialized = patterns.waveInitialized;
     
     const float WAVE_SPEED = 0.015f;    // Speed of wave movement
     const float WAVE_WIDTH = 2.0f * PI / MAX_OUTPUTS;    // How spread out the wave is
@@ -147,8 +258,8 @@ void StateManager::updateWave() {
     // Initialize random target hues if first run
     if (!huesInitialized) {
         for (int i = 0; i < MAX_OUTPUTS; i++) {
-            outputs[i].hue = random(256);
-            targetHues[i] = outputs[i].hue;
+            animOutputs.hue[i] = rng.next8();
+            targetHues[i] = animOutputs.hue[i];
         }
         huesInitialized = true;
         lastWavePosition = wavePosition;
@@ -161,33 +272,30 @@ void StateManager::updateWave() {
     for (int i = 0; i < MAX_OUTPUTS; i++) {
         if ((lastWavePosition < i && wavePosition >= i) || 
             (lastWavePosition > wavePosition && (lastWavePosition < i || wavePosition >= i))) {
-            outputs[i].hue = random(256); // new color as wave passes
+            animOutputs.hue[i] = rng.next8(); // new color as wave passes
         }
         
-        outputs[i].isOn = true;
-        
         // Calculate wave brightness using distance from wave peak
         float distance = abs((float)i - wavePosition);
         if (distance > MAX_OUTPUTS/2) {
             distance = MAX_OUTPUTS - distance;
         }
-        Serial.printf("%.2f ", distance);
+        // Serial.printf("%.2f ", distance);
         float brightness = cos(distance * WAVE_WIDTH);
         brightness = 1.0f - ((brightness + 1.0f) * 0.5f);  //  normalized wave
-        outputs[i].brightness = (uint8_t)(brightness * 255);
+        animOutputs.brightness[i] = (uint16_t)(brightness * MAX_BRIGHTNESS);
         
     }
-    // Serial.printf("%i, %i, %i, %i, %i, %i\n", outputs[0].brightness, outputs[1].brightness, outputs[2].brightness, outputs[3].brightness, outputs[4].brightness, outputs[5].brightness);
+    // Serial.printf("%i, %i, %i, %i, %i, %i\n", animOutputs.brightness[0], animOutputs.brightness[1], animOutputs.brightness[2], animOutputs.brightness[3], animOutputs.brightness[4], animOutputs.brightness[5]);
 
     lastWavePosition = wavePosition;
 }
 
 void StateManager::updatePulse() {
-    static float peakPosition = 0;
-    static bool isRising = true;
-    static uint8_t currentHue = 0;
+    float& peakPosition = patterns.pulsePeak;
+    bool& isRising = patterns.pulseRising;
+    uint8_t& currentHue = patterns.pulseHue;
     
-    const uint8_t MIN_BRIGHTNESS = 1;
     int HUE_STEP = 1;  // How quickly to transition hue (higher = faster)
 
     // Update peak position
@@ -207,17 +315,17 @@ void StateManager::updatePulse() {
 
     // Update hues with smooth transition
     for (int i = 0; i < MAX_OUTPUTS; i++) {
-        if (outputs[i].hue != currentHue) {
+        if (animOutputs.hue[i] != currentHue) {
             // Find shortest path to target hue (clockwise or counterclockwise)
-            int diff = currentHue - outputs[i].hue;
+            int diff = currentHue - animOutputs.hue[i];
             if (diff > 127) diff -= 256;
             else if (diff < -128) diff += 256;
             
             // Move hue closer to target by HUE_STEP
             if (diff > 0) {
-                outputs[i].hue = outputs[i].hue + min(HUE_STEP, diff);
+                animOutputs.hue[i] = animOutputs.hue[i] + min(HUE_STEP, diff);
             } else if (diff < 0) {
-                outputs[i].hue = outputs[i].hue - min(HUE_STEP, -diff);
+                animOutputs.hue[i] = animOutputs.hue[i] - min(HUE_STEP, -diff);
             }
         }
     }
@@ -225,42 +333,41 @@ void StateManager::updatePulse() {
     // Update brightnesses based on distance from peak
     for (int i = 0; i < MAX_OUTPUTS; i++) {
         if (i <= peakPosition) {
-            outputs[i].brightness = 255;
+            animOutputs.brightness[i] = MAX_BRIGHTNESS;
         } else {
             float distance = i - peakPosition;
             float falloff = max(0.0f, 1.0f - (distance / 3.0f));
-            uint8_t brightness = (uint8_t)(falloff * falloff * 255);
-            outputs[i].brightness = constrain(brightness, MIN_BRIGHTNESS, 255);
+            animOutputs.brightness[i] = (uint16_t)(falloff * falloff * MAX_BRIGHTNESS);
         }
     }
 
-    // Serial.printf("%i, %i, %i, %i, %i, %i\n", outputs[0].brightness, outputs[1].brightness, outputs[2].brightness, outputs[3].brightness, outputs[4].brightness, outputs[5].brightness);
+    // Serial.printf("%i, %i, %i, %i, %i, %i\n", animOutputs.brightness[0], animOutputs.brightness[1], animOutputs.brightness[2], animOutputs.brightness[3], animOutputs.brightness[4], animOutputs.brightness[5]);
 }
 
 void StateManager::updateSparkle() {
     // Randomly update brightness and hue for random LEDs
-    if (LEDUtils::random8() < 16) {  // Random sparkle probability
-        int led = LEDUtils::random8(MAX_OUTPUTS);
-        outputs[led].hue = LEDUtils::random8();
-        outputs[led].brightness = LEDUtils::random8(128, 255);  // Brighter range for better visibility
+    if (rng.next8() < 16) {  // Random sparkle probability
+        int led = rng.next8(MAX_OUTPUTS);
+        animOutputs.hue[led] = rng.next8();
+        animOutputs.brightness[led] = rng.next8(128, 255) * 257;  // Brighter range for better visibility
     }
     
+    const uint16_t FADE_STEP = 2 * 257;  // Same fade rate as the old 8-bit step of 2
+    
     // Gradually dim all LEDs
     for (int i = 0; i < MAX_OUTPUTS; i++) {
-        outputs[i].isOn = true;
-        if (outputs[i].brightness > 0) {  // Gradual fade out
-            outputs[i].brightness = max((int)outputs[i].brightness - 2, 0);
+        if (animOutputs.brightness[i] > 0) {  // Gradual fade out
+            animOutputs.brightness[i] = max((int)animOutputs.brightness[i] - FADE_STEP, 0);
         }
     }
 }
 
 void StateManager::updateChase() {
-    static float peakPosition = 0;
-    static uint8_t currentHue = 0;
+    float& peakPosition = patterns.chasePeak;
+    uint8_t& currentHue = patterns.chaseHue;
     
     const float MOVE_SPEED = 0.01f;  // Adjust for desired speed
     const float FALLOFF_DISTANCE = 2.0f;  // How many LEDs to spread the falloff over
-    const uint8_t MIN_BRIGHTNESS = 0;  // Minimum brightness in the falloff
     const uint8_t HUE_STEP = 1;  // How quickly the hue changes
     
     // Update peak position with wrapping
@@ -271,8 +378,6 @@ void StateManager::updateChase() {
     
     // Update all LEDs
     for (int i = 0; i < MAX_OUTPUTS; i++) {
-        outputs[i].isOn = true;
-        
         // Calculate shortest distance to peak, considering wrap-around
         float distance = abs(i - peakPosition);
         if (distance > MAX_OUTPUTS/2) {
@@ -294,15 +399,15 @@ void StateManager::updateChase() {
             falloff = 0.0f;
         }
         
-        outputs[i].brightness = constrain((uint8_t)(falloff * 255), MIN_BRIGHTNESS, 255);
-        outputs[i].hue = currentHue;  // All LEDs share the same gradually shifting hue
+        animOutputs.brightness[i] = (uint16_t)(falloff * MAX_BRIGHTNESS);
+        animOutputs.hue[i] = currentHue;  // All LEDs share the same gradually shifting hue
     }
 }
 
 void StateManager::updateBreathing() {
-    static float breathPosition = 0;
-    static uint8_t targetHues[MAX_OUTPUTS];
-    static bool huesInitialized = false;
+    float& breathPosition = patterns.breathPosition;
+    uint8_t (&targetHues)[MAX_OUTPUTS] = patterns.breathTargetHues;
+    bool& huesInitialized = patterns.breathInitialized;
     
     const float BREATH_SPEED = 0.02f;  // Adjust for desired breath rate
     const int HUE_STEP = 1;        // How quickly hues shift
@@ -311,8 +416,8 @@ void StateManager::updateBreathing() {
     // Initialize random target hues if first run
     if (!huesInitialized) {
         for (int i = 0; i < MAX_OUTPUTS; i++) {
-            outputs[i].hue = random(256);
-            targetHues[i] = outputs[i].hue;
+            animOutputs.hue[i] = rng.next8();
+            targetHues[i] = animOutputs.hue[i];
         }
         huesInitialized = true;
     }
@@ -323,27 +428,29 @@ void StateManager::updateBreathing() {
     // Calculate master brightness using sine wave
     float masterBrightness = (sin(breathPosition) + 1.0f) * 0.5f;  // Normalized to 0.0 - 1.0
     
+    // Two random bytes per output for this frame
+    uint8_t noise[MAX_OUTPUTS * 2];
+    rng.fill(noise, sizeof(noise));
+    
     for (int i = 0; i < MAX_OUTPUTS; i++) {
-        outputs[i].isOn = true;
-        
         // Randomly update target hue occasionally
-        if (random(100) < 2) {  // 2% chance each update
-            int8_t shift = random(-HUE_VARIATION, HUE_VARIATION + 1);
-            targetHues[i] = outputs[i].hue + shift;
+        if (noise[i * 2] < 5) {  // ~2% chance each update
+            int8_t shift = ((noise[i * 2 + 1] * (2 * HUE_VARIATION + 1)) >> 8) - HUE_VARIATION;
+            targetHues[i] = animOutputs.hue[i] + shift;
         }
         
         // Gradually shift current hue toward target
-        if (outputs[i].hue != targetHues[i]) {
+        if (animOutputs.hue[i] != targetHues[i]) {
             // Find shortest path to target hue
-            int diff = targetHues[i] - outputs[i].hue;
+            int diff = targetHues[i] - animOutputs.hue[i];
             if (diff > 127) diff -= 256;
             else if (diff < -128) diff += 256;
             
             // Move hue closer to target
             if (diff > 0) {
-                outputs[i].hue = outputs[i].hue + min(HUE_STEP, diff);
+                animOutputs.hue[i] = animOutputs.hue[i] + min(HUE_STEP, diff);
             } else if (diff < 0) {
-                outputs[i].hue = outputs[i].hue - min(HUE_STEP, -diff);
+                animOutputs.hue[i] = animOutputs.hue[i] - min(HUE_STEP, -diff);
             }
         }
         
@@ -351,9 +458,68 @@ void StateManager::updateBreathing() {
         float offsetPhase = breathPosition + (float)i * 0.2f;  // Adjust 0.2 for more/less offset
         float brightness = (sin(offsetPhase) + 1.0f) * 0.5f;
         
-        // Apply gamma correction for smoother brightness transitions
-        brightness = brightness * brightness;  // Square for gamma correction
+        // Gamma is applied downstream on the 16-bit frame
+        animOutputs.brightness[i] = (uint16_t)(brightness * MAX_BRIGHTNESS);
+    }
+}
+
+// Sound patterns
+void StateManager::updateSpectrum() {
+    uint8_t& hueDrift = patterns.spectrumDrift;
+    const uint16_t DECAY = MAX_BRIGHTNESS / 24;  // Fall back over ~0.5 s
+    
+    hueDrift++;
+    
+    for (int i = 0; i < MAX_OUTPUTS; i++) {
+        // Spread the bands across the outputs, bass first
+        int band = (i * AudioFeatures::NUM_BANDS) / MAX_OUTPUTS;
+        uint16_t target = audio.bands[band] * 257;
         
-        outputs[i].brightness = (uint8_t)(brightness * 255);
+        // Jump up to peaks, fall back slowly
+        uint16_t current = animOutputs.brightness[i];
+        animOutputs.brightness[i] = target > current ? target : (current > DECAY ? current - DECAY : 0);
+        animOutputs.hue[i] = band * (256 / AudioFeatures::NUM_BANDS) + (hueDrift >> 2);
+    }
+}
+
+void StateManager::updateBeatFlash() {
+    uint8_t& currentHue = patterns.beatHue;
+    
+    if (pendingBeat) {
+        pendingBeat = false;
+        currentHue += 64 + rng.next8(128);  // Clearly different color on every beat
+        for (int i = 0; i < MAX_OUTPUTS; i++) {
+            animOutputs.brightness[i] = MAX_BRIGHTNESS;
+        }
+    }
+    
+    for (int i = 0; i < MAX_OUTPUTS; i++) {
+        animOutputs.hue[i] = currentHue + animOutputs.animationOffset[i] / 8;
+        // Exponential decay, rounded up so the tail reaches black instead of stalling at 15
+        animOutputs.brightness[i] -= (animOutputs.brightness[i] + 15) >> 4;
+    }
+}
+
+void StateManager::updateLevelMeter() {
+    uint16_t& smoothedLevel = patterns.levelSmoothed;
+    
+    // Fast attack, slow release, 8 fractional bits
+    uint16_t level = audio.level << 8;
+    smoothedLevel = level > smoothedLevel ? level : smoothedLevel - (smoothedLevel >> 4);
+    
+    // Lit length in 1/256ths of an output
+    uint32_t lit = ((uint32_t)smoothedLevel * MAX_OUTPUTS) >> 8;
+    
+    for (int i = 0; i < MAX_OUTPUTS; i++) {
+        uint32_t start = (uint32_t)i << 8;
+        if (lit >= start + 256) {
+            animOutputs.brightness[i] = MAX_BRIGHTNESS;
+        } else if (lit > start) {
+            animOutputs.brightness[i] = (lit - start) * 257;  // Partially lit tip
+        } else {
+            animOutputs.brightness[i] = 0;
+        }
+        // Green at the bottom to red at the top
+        animOutputs.hue[i] = 96 - (i * 96) / MAX_OUTPUTS;
     }
 }
\ No newline at end of file
@@ -2,6 +2,11 @@
 #define STATE_MANAGER_H
 
 #include <Arduino.h>
+#include "config.h"
+#include "prng.h"
+#include "audio_analyzer.h"
+#include "triple_buffer.h"
+#include "events.h"
 
 /*
 Future Networking Implementation Notes:
@@ -15,49 +20,183 @@ Future Networking Implementation Notes:
   * Command queue for time-synchronized changes
 */
 
+// Snapshot of one output, as handed out by StateManager::getState()
 struct OutputState {
     bool isOn;
     uint8_t hue;
-    uint8_t brightness;
+    uint16_t brightness;        // 16-bit so low-end fades survive gamma
     bool isColorCycling;
     uint8_t animationOffset;    // Offset from base hue for animations
     // For future networking: unsigned long lastUpdateTime;
 };
 
+// Storage for all outputs as structure-of-arrays: flags are packed into
+// bitsets and each per-output value has its own array, so the per-tick
+// loops touch only the data they use as the output count grows.
+struct OutputBank {
+    static const int SIZE = NAMETAG_NUM_OUTPUTS;
+    static const int WORDS = (SIZE + 31) / 32;
+
+    uint32_t on[WORDS] = {};        // Bits past SIZE stay clear
+    uint32_t cycling[WORDS] = {};
+    uint8_t hue[SIZE];
+    uint16_t brightness[SIZE];
+    uint8_t animationOffset[SIZE];
+
+    static bool getBit(const uint32_t* bits, int index) {
+        return (bits[index >> 5] >> (index & 31)) & 1;
+    }
+
+    static void setBit(uint32_t* bits, int index, bool value) {
+        if (value) bits[index >> 5] |= (1UL << (index & 31));
+        else bits[index >> 5] &= ~(1UL << (index & 31));
+    }
+
+    // Mask of the bits that map to real outputs in word w
+    static uint32_t wordMask(int w) {
+        int remaining = SIZE - w * 32;
+        return remaining >= 32 ? 0xFFFFFFFFUL : ((1UL << remaining) - 1);
+    }
+
+    void reset(int index, uint16_t defaultBrightness) {
+        setBit(on, index, false);
+        setBit(cycling, index, false);
+        hue[index] = 0;
+        brightness[index] = defaultBrightness;
+        animationOffset[index] = 0;
+    }
+
+    void setAllOn() {
+        for (int w = 0; w < WORDS; w++) on[w] = wordMask(w);
+    }
+
+    OutputState get(int index) const {
+        return {getBit(on, index), hue[index], brightness[index],
+                getBit(cycling, index), animationOffset[index]};
+    }
+};
+
 struct AnimationState {
     uint8_t baseHue = 0;        // Base hue for animations
     uint8_t speed = 2;          // Animation speed
     uint8_t pattern = 0;        // Current animation pattern
     bool isAnimating = false;   // Global animation mode flag
+    bool soundReactive = false; // Speed follows the music, sound patterns selectable
+    uint8_t notifyCount = 0;    // Bumped by notify(), the renderer flashes on a change
+    uint8_t notifyHue = 0;
+};
+
+// Frame-to-frame memory of the animation patterns
+struct PatternState {
+    float rainbowOffset = 0;
+    float wavePosition = 0;
+    float lastWavePosition = 0;
+    uint8_t waveTargetHues[NAMETAG_NUM_OUTPUTS] = {};
+    bool waveInitialized = false;
+    float pulsePeak = 0;
+    bool pulseRising = true;
+    uint8_t pulseHue = 0;
+    float chasePeak = 0;
+    uint8_t chaseHue = 0;
+    float breathPosition = 0;
+    uint8_t breathTargetHues[NAMETAG_NUM_OUTPUTS] = {};
+    bool breathInitialized = false;
+    uint8_t spectrumDrift = 0;
+    uint8_t beatHue = 0;
+    uint16_t levelSmoothed = 0;
 };
 
+// Everything StateManager::update() depends on, plus the master brightness
+// the renderer applies. Saving and restoring it makes a tick reproducible
+// (record/replay keyframes).
+struct StateSnapshot {
+    OutputBank outputs;
+    OutputBank animOutputs;
+    AnimationState animState;
+    PatternState patterns;
+    uint32_t patternSeed;
+    uint32_t frameCount;
+    AudioFeatures audio;
+    bool pendingBeat;
+    uint8_t masterBrightness;
+};
+
+// Carries snapshots from the state tick to the renderer
+using StateBuffer = TripleBuffer<StateSnapshot>;
+
 class StateManager {
 public:
-    static const int MAX_OUTPUTS = 6;
-    static const int NUM_PATTERNS = 6;  // Number of animation patterns
+    static const int MAX_OUTPUTS = NAMETAG_NUM_OUTPUTS;
+    static const int NUM_BASE_PATTERNS = 6;     // Patterns picked by button index
+    static const int NUM_SOUND_PATTERNS = 3;    // Picked by button index in sound-reactive mode
+    static const int NUM_PATTERNS = NUM_BASE_PATTERNS + NUM_SOUND_PATTERNS;
+    static const uint8_t BASE_SPEED = 2;
+    static const uint16_t MAX_BRIGHTNESS = 0xFFFF;
+    static const uint8_t NOTIFY_ON_HUE = 85;    // Green
+    static const uint8_t NOTIFY_OFF_HUE = 0;    // Red
+    static const unsigned long UPDATE_INTERVAL_MS = 20;  // One state tick, run by the scheduler
     
     StateManager();
     
     // Core state management
     void toggleOutput(int index);
+    void setOutput(int index, bool isOn, uint8_t hue, uint16_t brightness);
     void setColorCycling(int index, bool enabled);
     void updateHue(int index);
-    void update();
+    void update();  // Advance one tick, call every UPDATE_INTERVAL_MS
     void resetOutput(int index);
-    const OutputState& getState(int index) const;
+    OutputState getState(int index) const;           // Whichever state is currently showing
+    OutputState getUserState(int index) const;       // User's colors, kept through party mode
+    OutputState getAnimationState(int index) const;  // Party mode pattern output
     bool isActive(int index) const;
     // for future networking: bool stateChanged;
+
+    // What each button gesture does. Live presses and replays both come
+    // through here.
+    void handleButtonEvent(const ButtonEventData& event);
     
     // Animation management
     void toggleAnimationMode();
-    void setAnimationPattern(uint8_t pattern);
+    bool setAnimationPattern(uint8_t pattern);     // False if not a pattern of the current mode
     uint8_t getAnimationPattern();
     void updateAnimations();
     bool isInAnimationMode() const { return animState.isAnimating; }
+
+    // Sound reactivity
+    void toggleSoundReactive();
+    bool isSoundReactive() const { return animState.soundReactive; }
+
+    // Flash the strip in this hue over whatever is showing, for a gesture
+    // with no visible effect of its own
+    void notify(uint8_t hue);
+    void setAudioFeatures(const AudioFeatures& features);
+
+    // Random patterns are reseeded every frame from (seed, frame), so badges
+    // given the same seed and frame number sparkle identically
+    void setRandomSeed(uint32_t seed, uint32_t frame = 0);
+    uint32_t getRandomSeed() const { return patternSeed; }
+    uint32_t getFrameCount() const { return frameCount; }
+
+    // Overall dimming (schedule brightness curves, blackout), 255 = full.
+    // Goes to the renderer in the snapshot like the rest of the state.
+    void setMasterBrightness(uint8_t level) { masterBrightness = level; }
+    uint8_t getMasterBrightness() const { return masterBrightness; }
+
+    void saveSnapshot(StateSnapshot& snapshot) const;
+    void restoreSnapshot(const StateSnapshot& snapshot);
+    void publish(StateBuffer& buffer) const;   // Snapshot for the renderer
     
 private:
-    OutputState outputs[MAX_OUTPUTS];
+    OutputBank outputs;         // User layer
+    OutputBank animOutputs;     // Animation layer
     AnimationState animState;
+    PatternState patterns;
+    Prng rng;
+    uint32_t patternSeed = 0;
+    uint32_t frameCount = 0;
+    AudioFeatures audio = {};
+    bool pendingBeat = false;   // Latched until a pattern uses it
+    uint8_t masterBrightness = 255;
     
     // Animation patterns
     void updateRainbow();
@@ -66,6 +205,9 @@ private:
     void updateSparkle();
     void updateChase();
     void updateBreathing();
+    void updateSpectrum();
+    void updateBeatFlash();
+    void updateLevelMeter();
 };
 
 #endif // STATE_MANAGER_H
\ No newline at end of file
@@ -0,0 +1,77 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <Arduino.h>
+#include "config.h"
+#ifdef USE_RENDER_THREAD
+#include <atomic>
+#endif
+
+// Lock-free single-writer/single-reader handoff. The writer fills its own
+// slot and publishes it by swapping it with the middle one; the reader swaps
+// the middle one out only when something new was published. Neither side
+// ever waits, and the reader's slot never changes under it, so it always
+// sees a whole snapshot.
+template <typename T>
+class TripleBuffer {
+public:
+    T& writeBuffer() { return slots[writeIndex]; }
+
+    void publish() {
+        writeIndex = swapMiddle(writeIndex | FRESH) & INDEX_MASK;
+    }
+
+    // Latest published value, stable until the next read()
+    const T& read() {
+        if (loadMiddle() & FRESH) {
+            readIndex = swapMiddle(readIndex) & INDEX_MASK;
+        }
+        return slots[readIndex];
+    }
+
+private:
+    static const uint8_t INDEX_MASK = 0x03;
+    static const uint8_t FRESH = 0x80;     // Middle slot not yet read
+
+    T slots[3];
+    uint8_t writeIndex = 0;
+    uint8_t readIndex = 2;
+#ifdef USE_RENDER_THREAD
+    std::atomic<uint8_t> middle{1};
+
+    uint8_t loadMiddle() const { return middle.load(std::memory_order_acquire); }
+    uint8_t swapMiddle(uint8_t value) { return middle.exchange(value, std::memory_order_acq_rel); }
+#else
+    // Single threaded: writer and reader take turns in loop()
+    uint8_t middle = 1;
+
+    uint8_t loadMiddle() const { return middle; }
+    uint8_t swapMiddle(uint8_t value) {
+        uint8_t previous = middle;
+        middle = value;
+        return previous;
+    }
+#endif
+};
+
+// One value written on one side and read on the other, for the odd counter
+// that doesn't belong in a snapshot
+template <typename T>
+class SharedValue {
+public:
+#ifdef USE_RENDER_THREAD
+    void store(T newValue) { value.store(newValue, std::memory_order_release); }
+    T load() const { return value.load(std::memory_order_acquire); }
+
+private:
+    std::atomic<T> value{};
+#else
+    void store(T newValue) { value = newValue; }
+    T load() const { return value; }
+
+private:
+    T value = {};
+#endif
+};
+
+#endif
\ No newline at end of file